@@ -1,7 +1,9 @@
 # Copyright(c) Nicolas VENTER All rights reserved.
 
-filenames = ['Displayer.hpp', 'extra/BoxDisplayer.hpp', 'extra/CsvDisplayer.hpp',
-             'extra/ExtraDisplayer.hpp', 'extra/JsonDisplayer.hpp']
+filenames = ['DisplayWidth.hpp', 'Displayer.hpp', 'extra/NumberFormat.hpp', 'extra/ColumnAggregator.hpp', 'extra/BoxDisplayer.hpp', 'extra/CsvDisplayer.hpp',
+             'extra/ExtraDisplayer.hpp', 'extra/JsonDisplayer.hpp', 'extra/AsyncDisplayer.hpp',
+             'extra/BinaryDisplayer.hpp', 'extra/WindowDisplayer.hpp',
+             'extra/FanOutDisplayer.hpp', 'extra/TopKCollector.hpp', 'extra/GzipStream.hpp']
 with open('AllDisplayers.hpp', 'w') as outfile:
     with open('ArrayConverter.hpp') as infile:
         for line in infile:
@@ -11,7 +13,7 @@ with open('AllDisplayers.hpp', 'w') as outfile:
     for fname in filenames:
         with open(fname) as infile:
             for line in infile:
-                if line in ['// Copyright (c) Nicolas VENTER All rights reserved.\n', '#pragma once\n', '#include "../Displayer.hpp"\n', '#include "ArrayConverter.hpp"\n']:
+                if line in ['// Copyright (c) Nicolas VENTER All rights reserved.\n', '#pragma once\n', '#include "../Displayer.hpp"\n', '#include "ArrayConverter.hpp"\n', '#include "DisplayWidth.hpp"\n', '#include "BoxDisplayer.hpp"\n', '#include "NumberFormat.hpp"\n', '#include "ColumnAggregator.hpp"\n']:
                     continue
                 if line == '// ============================================================\n':
                     break
@@ -41,7 +43,7 @@ with open('AllDisplayers.hpp', 'w') as outfile:
         with open(fname) as infile:
             lineFound = 0
             for line in infile:
-                if line in ['// Copyright (c) Nicolas VENTER All rights reserved.\n', '#pragma once\n', '#include "../Displayer.hpp"\n', '#include "ArrayConverter.hpp"\n']:
+                if line in ['// Copyright (c) Nicolas VENTER All rights reserved.\n', '#pragma once\n', '#include "../Displayer.hpp"\n', '#include "ArrayConverter.hpp"\n', '#include "DisplayWidth.hpp"\n', '#include "BoxDisplayer.hpp"\n', '#include "NumberFormat.hpp"\n', '#include "ColumnAggregator.hpp"\n']:
                     continue
                 if lineFound == 2:
                     outfile.write(line)
@@ -22,11 +22,12 @@ public:
 	std::string toString();
 };
 
-static OstreamFunc defaultOstreamFunc = OSTREAM_FUNC_LAMBDA() { return os; };
+// OstreamFunc that does nothing, defined once and constructed on first use
+const OstreamFunc& defaultOstreamFunc();
 
 struct ArrayConverter
 {
-	explicit ArrayConverter(const OstreamFunc& ostreamFunc_ = defaultOstreamFunc,
+	explicit ArrayConverter(const OstreamFunc& ostreamFunc_ = defaultOstreamFunc(),
 		const std::string& separator_ = ", ",
 		const std::string& prefix_ = "[",
 		const std::string& suffix_ = "]");
@@ -57,6 +58,12 @@ struct ArrayConverter
 
 std::ostream& operator<<(std::ostream& os, const OstreamFunc& ostreamFunc) { return ostreamFunc(os); }
 
+const OstreamFunc& defaultOstreamFunc()
+{
+	static OstreamFunc defaultOstreamFunc_ = OSTREAM_FUNC_LAMBDA() { return os; };
+	return defaultOstreamFunc_;
+}
+
 std::string OstreamFunc::toString()
 {
 	std::ostringstream oss;
@@ -3,14 +3,17 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "ArrayConverter.hpp"
+#include "DisplayWidth.hpp"
 
 #define DISPLAY_FUNC_PARAM std::ostream& os
 // parameters are catpures
@@ -28,6 +31,16 @@ public:
 	explicit DisplayFunc(const std::string& s);
 
 	std::string toString() const;
+
+public:
+	// true if the DisplayFunc pads its output according to its display width itself
+	// otherwise a Displayer with bDisplayWidthPadding renders it first and pads it according to its display width
+	bool bAppliesWidth = false;
+
+	// true if numericValue is the number displayed (set by the number formatters like int_ and fixed_)
+	// used to aggregate the cell without rendering and parsing it
+	bool bHasNumericValue = false;
+	double numericValue = 0;
 };
 
 // shortcut to use in simplified constructor
@@ -54,6 +67,34 @@ public:
 	const DisplayFunc* pFind(const std::string& key) const;
 };
 
+using KeySet = std::unordered_set<std::string>;
+
+// object to display that only builds the DisplayFunc of the keys in keySet
+// to use like this: return ProjectedDisplayFuncMap(keySet).add(PersonKeys.name, [this]() { return name; });
+class ProjectedDisplayFuncMap : public DisplayFuncMap
+{
+public:
+	// keySet must outlive the calls to add
+	explicit ProjectedDisplayFuncMap(const KeySet& keySet);
+
+	// call cellBuilder (returning a std::string or a DisplayFunc) only if the key is in keySet
+	template <typename F> ProjectedDisplayFuncMap& add(const std::string& key, const F& cellBuilder) &
+	{
+		if (pKeySet->count(key)) emplace(key, DisplayFunc(cellBuilder()));
+		return *this;
+	}
+
+	// same on a temporary, the map is moved (not copied) along the chain and to the returned object
+	template <typename F> ProjectedDisplayFuncMap add(const std::string& key, const F& cellBuilder) &&
+	{
+		add(key, cellBuilder);
+		return std::move(*this);
+	}
+
+private:
+	const KeySet* pKeySet;
+};
+
 // EDF = Extension Display Func
 #define EDF_PARAM std::ostream &os, DisplayFunc displayFunc
 // parameters are catpures
@@ -84,20 +125,36 @@ std::string bool_to_string(bool b);
 
 namespace displayer
 {
-	static const std::string left_ = "left_";
-	static const std::string right_ = "right_";
+	// compile time constants, no static initialization in the including translation units
+	constexpr const char left_[] = "left_";
+	constexpr const char right_[] = "right_";
+	// the keys of setw_, setfill_ and string_ are not registered in globalDisplayFuncMap
+	// they are applied to the stream from the key itself when displayed
 	std::string setw_(long long streamsize);
 	std::string setfill_(char c);
 	std::string string_(const std::string& s);
 
 	// object used to customize the display of a key not found in the object to display
-	static DisplayFuncMap globalDisplayFuncMap{
-		{left_, std::left},
-		{right_, std::right},
-	};
+	// defined once and constructed on first use
+	DisplayFuncMap& globalDisplayFuncMap();
 
 	// object used to extend the display of a key by using the display func stored in object
-	static std::unordered_map<std::string, ExtensionDisplayFunc> globalEdfMap;
+	// defined once and constructed on first use
+	std::unordered_map<std::string, ExtensionDisplayFunc>& globalEdfMap();
+
+	// apply to os the key returned by setw_, setfill_ or string_ (without creating a DisplayFunc)
+	// return false if the key is not one of them
+	bool applyDisplayerKey(std::ostream& os, const std::string& key);
+
+	// return true if the key is not a key of the object to display
+	// (key of globalDisplayFuncMap or key returned by setw_, setfill_ or string_)
+	bool isDisplayerKey(const std::string& key);
+
+	// key list parsed from a format string, the displayer constructed with it keeps the parsed keys
+	// each field is {key} or {key:[fill][<|>][width]}, use {{ and }} to display braces
+	// a field with a width and without < or > is right aligned
+	// to use like this: ExtraDisplayer(layout_("{name:<10} | {money:*>10}"))
+	SL layout_(const std::string& format);
 } // namespace displayer
 
 // class that contains the list of keys to display
@@ -111,15 +168,28 @@ private:
 public:
 	using parentType::parentType;
 
-	// function executed when a key to display is not found, neither in object, nor in displayer::globalDisplayFuncMap
+	// function executed when a key to display is not found, neither in object, nor in displayer::globalDisplayFuncMap,
+	// nor returned by setw_, setfill_ or string_
 	KeyNotFoundCallback onKeyNotFound = defaultKeyNotFound;
 
+	// pad the cells according to their display width (UTF-8 wide and combining characters) instead of their size in bytes
+	// the cells that do not apply the width themselves are then rendered before being padded, which is slower
+	// to use like this: myDisplayer.bDisplayWidthPadding = true;
+	bool bDisplayWidthPadding = false;
+
 	// function used to display an object
 	// to use like this: std::cout << myDisplayer.display(myDisplayFuncMap) << std::endl;
 	OstreamFunc display(const DisplayFuncMap& displayFuncMap);
 
+	// keys of the object to display used by the displayer (keys of setw_, string_... excluded)
+	// to use like this: ProjectedDisplayFuncMap(myDisplayer.getReferencedKeySet())
+	KeySet getReferencedKeySet() const;
+
 private:
 	DisplayFunc getKeyNotFoundDisplayFunc(const std::string& key) const;
+
+	// call f and pad its output according to the display width when a width is set in os
+	template <typename F> static void s_displayPadded(std::ostream& os, const F& f);
 };
 
 // ============================================================
@@ -155,6 +225,8 @@ const DisplayFunc* DisplayFuncMap::pFind(const std::string& key) const
 	return it == end() ? nullptr : &it->second;
 }
 
+ProjectedDisplayFuncMap::ProjectedDisplayFuncMap(const KeySet& keySet) : pKeySet(&keySet) {}
+
 ExtensionDisplayFunc::ExtensionDisplayFunc(const DisplayFunc& displayFunc_) :
 	ExtensionDisplayFunc(EDF_LAMBDA(displayFunc_) { displayFunc_(os); })
 {
@@ -164,44 +236,248 @@ std::string bool_to_string(bool b) { return b ? "true" : "false"; }
 
 namespace displayer
 {
-	std::string setw_(long long streamsize)
+	DisplayFuncMap& globalDisplayFuncMap()
+	{
+		static DisplayFuncMap globalDisplayFuncMap_{
+			{left_, std::left},
+			{right_, std::right},
+		};
+		return globalDisplayFuncMap_;
+	}
+
+	std::unordered_map<std::string, ExtensionDisplayFunc>& globalEdfMap()
+	{
+		static std::unordered_map<std::string, ExtensionDisplayFunc> globalEdfMap_;
+		return globalEdfMap_;
+	}
+
+	// not std::string so that setw_, setfill_ and string_ can be used during static initialization
+	static constexpr const char s_setwPrefix[] = "setw:";
+	static constexpr const char s_setfillPrefix[] = "setfill:";
+	static constexpr const char s_stringPrefix[] = "string:";
+
+	template <size_t N> static constexpr size_t s_prefixSize(const char (&)[N]) { return N - 1; }
+
+	template <size_t N> static bool s_startsWith(const std::string& s, const char (&prefix)[N])
+	{
+		// memcmp of a constant size, std::string::compare is significant in the cost of a displayed row
+		return s.size() >= N - 1 && std::memcmp(s.data(), prefix, N - 1) == 0;
+	}
+
+	std::string setw_(long long streamsize) { return s_setwPrefix + std::to_string(streamsize); }
+
+	std::string setfill_(char c) { return s_setfillPrefix + std::string(1, c); }
+
+	std::string string_(const std::string& s) { return s_stringPrefix + s; }
+
+	enum DisplayerKeyType : uint8_t
+	{
+		NOT_DISPLAYER_KEY,
+		STRING_KEY,
+		SETFILL_KEY,
+		SETW_KEY
+	};
+
+	// single parser of the keys returned by setw_, setfill_ and string_, streamsize is set for SETW_KEY
+	static DisplayerKeyType s_parseDisplayerKey(const std::string& key, long long& streamsize)
+	{
+		// all the prefixes start with 's', most keys of the object to display are rejected on their first character
+		if (key.empty() || key[0] != 's') return DisplayerKeyType::NOT_DISPLAYER_KEY;
+		if (s_startsWith(key, s_stringPrefix)) return DisplayerKeyType::STRING_KEY;
+		if (s_startsWith(key, s_setfillPrefix))
+			return key.size() == s_prefixSize(s_setfillPrefix) + 1 ? DisplayerKeyType::SETFILL_KEY : DisplayerKeyType::NOT_DISPLAYER_KEY;
+		if (!s_startsWith(key, s_setwPrefix)) return DisplayerKeyType::NOT_DISPLAYER_KEY;
+		// parsed by hand, strtoll is significant in the cost of a displayed row (and accepts spaces and '+')
+		size_t i = s_prefixSize(s_setwPrefix);
+		bool bNegative = i < key.size() && key[i] == '-';
+		if (bNegative) ++i;
+		if (i == key.size()) return DisplayerKeyType::NOT_DISPLAYER_KEY;
+		streamsize = 0;
+		for (; i < key.size(); ++i)
+		{
+			if (key[i] < '0' || key[i] > '9') return DisplayerKeyType::NOT_DISPLAYER_KEY;
+			streamsize = streamsize * 10 + (key[i] - '0');
+		}
+		if (bNegative) streamsize = -streamsize;
+		return DisplayerKeyType::SETW_KEY;
+	}
+
+	// static so that it can be inlined in the display loop
+	static bool s_applyDisplayerKey(std::ostream& os, const std::string& key)
 	{
-		std::string key = "setw:" + std::to_string(streamsize);
-		globalDisplayFuncMap.emplace(
-			key, DISPLAY_FUNC_LAMBDA(streamsize) { os << std::setw(streamsize); });
-		return key;
+		long long streamsize;
+		switch (s_parseDisplayerKey(key, streamsize))
+		{
+		case DisplayerKeyType::STRING_KEY:
+			writePadded(os, key.data() + s_prefixSize(s_stringPrefix), key.size() - s_prefixSize(s_stringPrefix));
+			return true;
+		case DisplayerKeyType::SETFILL_KEY: os.fill(key.back()); return true;
+		case DisplayerKeyType::SETW_KEY: os.width(static_cast<std::streamsize>(streamsize)); return true;
+		default: return false;
+		}
 	}
 
-	std::string setfill_(char c)
+	bool applyDisplayerKey(std::ostream& os, const std::string& key) { return s_applyDisplayerKey(os, key); }
+
+	bool isDisplayerKey(const std::string& key)
 	{
-		std::string key = "setfill:" + c;
-		globalDisplayFuncMap.emplace(
-			key, DISPLAY_FUNC_LAMBDA(c) { os << std::setfill(c); });
-		return key;
+		long long streamsize;
+		return globalDisplayFuncMap().count(key) || s_parseDisplayerKey(key, streamsize) != DisplayerKeyType::NOT_DISPLAYER_KEY;
 	}
 
-	std::string string_(const std::string& s)
+	// parse the spec of a field, return false if spec is not [fill][<|>][width]
+	static bool s_parseFieldSpec(const std::string& spec, char& fill, char& align, long long& width)
 	{
-		std::string key = "string:" + s;
-		globalDisplayFuncMap.emplace(key, DisplayFunc(s));
-		return key;
+		size_t i = 0;
+		if (spec.size() >= 2 && (spec[1] == '<' || spec[1] == '>'))
+		{
+			fill = spec[0];
+			align = spec[1];
+			i = 2;
+		}
+		else if (!spec.empty() && (spec[0] == '<' || spec[0] == '>'))
+		{
+			align = spec[0];
+			i = 1;
+		}
+		for (; i < spec.size(); ++i)
+		{
+			if (spec[i] < '0' || spec[i] > '9') return false;
+			width = width * 10 + (spec[i] - '0');
+		}
+		return true;
+	}
+
+	SL layout_(const std::string& format)
+	{
+		SL result;
+		std::string text;
+		bool bFillChanged = false;
+		for (size_t i = 0; i < format.size(); ++i)
+		{
+			char c = format[i];
+			if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c)
+			{
+				text += c;
+				++i;
+				continue;
+			}
+			size_t end = c == '{' ? format.find('}', i + 1) : std::string::npos;
+			if (end == std::string::npos)
+			{
+				text += c;
+				continue;
+			}
+			if (!text.empty()) result.push_back(string_(text));
+			text.clear();
+
+			std::string field = format.substr(i + 1, end - i - 1);
+			i = end;
+			char fill = ' ';
+			char align = 0;
+			long long width = 0;
+			size_t colon = field.rfind(':');
+			if (colon != std::string::npos && s_parseFieldSpec(field.substr(colon + 1), fill, align, width))
+				field.resize(colon);
+			else
+				fill = ' ', align = 0, width = 0;
+
+			// the alignment and the fill are set for each field with a width,
+			// so that they do not depend on the previous row or on the previous displayer of the stream
+			if (width != 0)
+			{
+				result.push_back(align == '<' ? left_ : right_);
+				result.push_back(setfill_(fill));
+				result.push_back(setw_(width));
+				if (fill != ' ') bFillChanged = true;
+			}
+			result.push_back(field);
+		}
+		if (!text.empty()) result.push_back(string_(text));
+		if (bFillChanged) result.push_back(setfill_(' ')); // the stream is left with the default fill
+		return result;
 	}
 } // namespace displayer
 
 void Displayer::defaultKeyNotFound(KEY_NOT_FOUND_PARAM) { os << std::string(key + ":???"); }
 
+namespace displayer
+{
+	// streambuf writing in a local buffer that grows on the heap if needed, used to render a cell before padding it
+	class ScratchStreambuf : public std::streambuf
+	{
+	public:
+		ScratchStreambuf() { setp(localBuffer, localBuffer + sizeof(localBuffer)); }
+
+		const char* data() const { return pbase(); }
+		size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+
+	protected:
+		int_type overflow(int_type c) override
+		{
+			size_t size_ = size();
+			if (heapBuffer.empty()) heapBuffer.assign(localBuffer, size_);
+			heapBuffer.resize(std::max<size_t>(size_ * 2, 2 * sizeof(localBuffer)));
+			setp(&heapBuffer[0], &heapBuffer[0] + heapBuffer.size());
+			pbump(static_cast<int>(size_));
+			if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+			return c;
+		}
+
+	private:
+		char localBuffer[128];
+		std::string heapBuffer;
+	};
+} // namespace displayer
+
+template <typename F> void Displayer::s_displayPadded(std::ostream& os, const F& f)
+{
+	if (os.width() <= 0)
+	{
+		f(os);
+		return;
+	}
+	// render the cell with the format of os into a scratch buffer (the streambuf of os is swapped, no format copy)
+	displayer::ScratchStreambuf scratchStreambuf;
+	auto width = os.width(0);
+	auto state = os.rdstate();
+	std::streambuf* pStreambuf = os.rdbuf(&scratchStreambuf);
+	f(os);
+	os.rdbuf(pStreambuf);
+	os.clear(state);
+	os.width(width);
+	displayer::writePadded(os, scratchStreambuf.data(), scratchStreambuf.size());
+}
+
 OstreamFunc Displayer::display(const DisplayFuncMap& displayFuncMap)
 {
 	return OSTREAM_FUNC_LAMBDA(this, &displayFuncMap)
 	{
+		const auto& globalDisplayFuncMap = displayer::globalDisplayFuncMap();
+		const auto& edfMap = displayer::globalEdfMap();
 		for (const auto& key : *this)
 		{
+			// keys of setw_, setfill_ and string_ are recognized by their prefix, before any lookup
+			if (displayer::s_applyDisplayerKey(os, key)) continue;
 			auto displayFunc = displayFuncMap.pFind(key);
-			auto it = displayer::globalEdfMap.find(key);
-			if (it != displayer::globalEdfMap.end()) it->second(os, displayFunc ? *displayFunc : getKeyNotFoundDisplayFunc(key));
+			auto it = edfMap.empty() ? edfMap.end() : edfMap.find(key);
+			if (it != edfMap.end())
+			{
+				const auto& edf = it->second;
+				DisplayFunc edfDisplayFunc = displayFunc ? *displayFunc : getKeyNotFoundDisplayFunc(key);
+				if (!bDisplayWidthPadding) edf(os, edfDisplayFunc);
+				else
+					s_displayPadded(os, [&edf, &edfDisplayFunc](std::ostream& cellOs) { edf(cellOs, edfDisplayFunc); });
+			}
 			else if (displayFunc)
-				(*displayFunc)(os);
-			else if (auto globalDisplayFunc = displayer::globalDisplayFuncMap.pFind(key))
+			{
+				if (bDisplayWidthPadding && !displayFunc->bAppliesWidth) s_displayPadded(os, *displayFunc);
+				else
+					(*displayFunc)(os);
+			}
+			else if (auto globalDisplayFunc = globalDisplayFuncMap.pFind(key))
 				(*globalDisplayFunc)(os);
 			else
 				onKeyNotFound(os, key);
@@ -210,6 +486,14 @@ OstreamFunc Displayer::display(const DisplayFuncMap& displayFuncMap)
 	};
 }
 
+KeySet Displayer::getReferencedKeySet() const
+{
+	KeySet keySet;
+	for (const auto& key : *this)
+		if (!displayer::isDisplayerKey(key)) keySet.insert(key);
+	return keySet;
+}
+
 DisplayFunc Displayer::getKeyNotFoundDisplayFunc(const std::string& key) const
 {
 	return DISPLAY_FUNC_LAMBDA(this, key) { onKeyNotFound(os, key); };
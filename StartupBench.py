@@ -0,0 +1,50 @@
+# Copyright(c) Nicolas VENTER All rights reserved.
+
+# measure the startup time and the binary size of a program made of many translation units including AllDisplayers.hpp
+# usage: python StartupBench.py [tuCount] [runCount] [compiler]
+
+import concurrent.futures
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+tuCount = int(sys.argv[1]) if len(sys.argv) > 1 else 200
+runCount = int(sys.argv[2]) if len(sys.argv) > 2 else 50
+compiler = sys.argv[3] if len(sys.argv) > 3 else 'g++'
+
+scriptDir = os.path.dirname(os.path.abspath(__file__))
+subprocess.check_call([sys.executable, 'AllInOne.py'], cwd=scriptDir)
+
+with tempfile.TemporaryDirectory() as tmpDir:
+    sourceList = []
+    for i in range(tuCount):
+        source = os.path.join(tmpDir, 'tu%d.cpp' % i)
+        with open(source, 'w') as outfile:
+            outfile.write('#include "AllDisplayers.hpp"\n')
+            outfile.write('std::string tu%d() { return displayer::setw_(%d); }\n' % (i, i))
+        sourceList.append(source)
+    main = os.path.join(tmpDir, 'main.cpp')
+    with open(main, 'w') as outfile:
+        outfile.write('#define DISPLAYER_IMPLEMENTATION\n')
+        outfile.write('#include "AllDisplayers.hpp"\n')
+        outfile.write('int main() { return 0; }\n')
+    sourceList.append(main)
+
+    objectList = [source[:-len('.cpp')] + '.o' for source in sourceList]
+    with concurrent.futures.ThreadPoolExecutor(os.cpu_count()) as executor:
+        for future in [executor.submit(subprocess.check_call, [compiler, '-std=c++11', '-O2', '-c', '-I', scriptDir, source, '-o', obj])
+                       for source, obj in zip(sourceList, objectList)]:
+            future.result()
+    exe = os.path.join(tmpDir, 'bench.exe')
+    subprocess.check_call([compiler, '-pthread'] + objectList + ['-o', exe])
+
+    startTime = time.perf_counter()
+    for _ in range(runCount):
+        subprocess.check_call([exe])
+    elapsed = (time.perf_counter() - startTime) / runCount
+
+    print('translation units: %d' % tuCount)
+    print('binary size:       %d bytes' % os.path.getsize(exe))
+    print('startup time:      %.3f ms (process creation included, mean of %d runs)' % (elapsed * 1000, runCount))
@@ -0,0 +1,405 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../Displayer.hpp"
+#include "NumberFormat.hpp"
+
+// policy applied by AsyncDisplayer::push when the queue is full
+enum QueueFullPolicy : uint8_t
+{
+	BLOCK,	// wait until a slot is free (the producer sleeps until the consumer thread frees a slot)
+	DROP,	// drop the row
+	SAMPLE, // keep one row over sampleRate (waiting for a free slot), drop the others
+};
+
+// type of a value pushed with AsyncDisplayer::pushValues
+enum AsyncValueType : uint8_t
+{
+	INT64_VALUE,
+	UINT64_VALUE,
+	DOUBLE_VALUE,
+	BOOL_VALUE,
+	STRING_VALUE,
+};
+
+// displayer that formats and writes rows in a dedicated consumer thread
+// rows are pushed in a bounded lock-free multi-producer queue, the idle consumer thread sleeps until a row is pushed
+class AsyncDisplayer
+{
+public:
+	// displayer and os must outlive the AsyncDisplayer
+	// capacity is rounded up to a power of 2
+	// to use like this: AsyncDisplayer asyncDisplayer(myDisplayer, std::cout, 1024, QueueFullPolicy::DROP)
+	AsyncDisplayer(Displayer& displayer_,
+		std::ostream& os_,
+		size_t capacity = 1024,
+		QueueFullPolicy queueFullPolicy_ = QueueFullPolicy::BLOCK,
+		uint32_t sampleRate_ = 16);
+
+	// display the remaining rows and stop the consumer thread
+	~AsyncDisplayer();
+
+	AsyncDisplayer(const AsyncDisplayer&) = delete;
+	AsyncDisplayer& operator=(const AsyncDisplayer&) = delete;
+
+	// thread safe, the displayFuncMap must only capture values (no reference)
+	// return false if the row has been dropped
+	bool push(DisplayFuncMap displayFuncMap);
+
+	// thread safe, push the values of the keys of the displayer (keys of setw_, string_... excluded) in their order
+	// the keys are read when the AsyncDisplayer is constructed, the DisplayFunc displaying the values are created once
+	// the values are copied in the preallocated slot of the row
+	// return false if the row has been dropped or if the number of values is not the number of keys
+	// to use like this: asyncDisplayer.pushValues(name, age, money)
+	template <typename... Args> bool pushValues(const Args&... args)
+	{
+		if (sizeof...(Args) != valueKeyList.size()) return false;
+		size_t pos;
+		Slot* pSlot = claimSlot(pos);
+		if (!pSlot) return false;
+		pSlot->bValueRow = true;
+		pSlot->valueList.resize(sizeof...(Args)); // only allocated on the first use of the slot
+		Value* pValue = pSlot->valueList.data();
+		int expander[] = {0, (setValue(*pValue++, args), 0)...};
+		(void)expander;
+		publishSlot(*pSlot, pos);
+		return true;
+	}
+
+	// wait until all the rows pushed before the call are displayed and os is flushed
+	void flush();
+
+	uint64_t getDroppedCount() const;
+
+public:
+	// string displayed after each row
+	std::string rowSuffix = "\n";
+
+private:
+	struct Value
+	{
+		uint8_t type = AsyncValueType::STRING_VALUE;
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double d;
+			bool b;
+		};
+		std::string s; // its capacity is kept from one row to the next
+	};
+
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		bool bValueRow = false; // row pushed with pushValues (valueList) or with push (displayFuncMap)
+		DisplayFuncMap displayFuncMap;
+		std::vector<Value> valueList;
+	};
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type setValue(Value& value, const T& t)
+	{
+		value.type = AsyncValueType::INT64_VALUE;
+		value.i = static_cast<int64_t>(t);
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type setValue(Value& value, const T& t)
+	{
+		value.type = AsyncValueType::UINT64_VALUE;
+		value.u = static_cast<uint64_t>(t);
+	}
+
+	template <typename T> typename std::enable_if<std::is_floating_point<T>::value>::type setValue(Value& value, const T& t)
+	{
+		value.type = AsyncValueType::DOUBLE_VALUE;
+		value.d = static_cast<double>(t);
+	}
+
+	void setValue(Value& value, bool b);
+	void setValue(Value& value, const std::string& s);
+	void setValue(Value& value, const char* s);
+
+	// return the slot reserved at pos, applying the QueueFullPolicy if the queue is full
+	// return nullptr if the row is dropped
+	Slot* claimSlot(size_t& pos);
+	Slot* tryClaimSlot(size_t& pos);
+
+	// make the row of the slot visible to the consumer thread
+	void publishSlot(Slot& slot, size_t pos);
+
+	// display the next row from its slot and free the slot, return false if the queue is empty
+	bool tryPop();
+	void consume();
+
+	// wake up the consumer thread if it is sleeping
+	void notifyConsumer();
+
+	Displayer& displayer;
+	std::ostream& os;
+	QueueFullPolicy queueFullPolicy;
+	uint32_t sampleRate;
+
+	SL valueKeyList;					   // keys of the values of pushValues
+	DisplayFuncMap valueDisplayFuncMap;	   // display the values of pDisplayedValueList, used by the consumer thread
+	const std::vector<Value>* pDisplayedValueList = nullptr;
+
+	std::unique_ptr<Slot[]> slotList;
+	size_t mask;
+	std::atomic<size_t> enqueuePos;
+	std::atomic<size_t> dequeuePos;
+	std::atomic<size_t> displayedPos; // updated once os is flushed
+	std::atomic<size_t> flushPos;	  // position requested by flush
+	std::atomic<uint64_t> droppedCount;
+	std::atomic<uint64_t> fullCount;
+	std::atomic<bool> bStop;
+	std::atomic<bool> bConsumerSleeping;
+	std::atomic<uint32_t> waitingProducerCount; // producers waiting for a free slot
+	std::mutex mutex;
+	std::condition_variable consumerCondition; // notified when there is something to do for the consumer thread
+	std::condition_variable flushCondition;	   // notified when displayedPos is updated
+	std::condition_variable slotCondition;	   // notified when a slot is freed while producers are waiting
+	std::thread consumerThread;
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+AsyncDisplayer::AsyncDisplayer(
+	Displayer& displayer_, std::ostream& os_, size_t capacity, QueueFullPolicy queueFullPolicy_, uint32_t sampleRate_) :
+	displayer(displayer_),
+	os(os_), queueFullPolicy(queueFullPolicy_), sampleRate(sampleRate_ ? sampleRate_ : 1), enqueuePos(0), dequeuePos(0),
+	displayedPos(0), flushPos(0), droppedCount(0), fullCount(0), bStop(false), bConsumerSleeping(false), waitingProducerCount(0)
+{
+	for (const auto& key : displayer)
+		if (!displayer::isDisplayerKey(key) && std::find(valueKeyList.begin(), valueKeyList.end(), key) == valueKeyList.end())
+			valueKeyList.push_back(key);
+	for (size_t i = 0; i < valueKeyList.size(); ++i)
+	{
+		valueDisplayFuncMap.emplace(valueKeyList[i],
+			DISPLAY_FUNC_LAMBDA(this, i) {
+				const Value& value = (*pDisplayedValueList)[i];
+				char buffer[32];
+				switch (value.type)
+				{
+				case AsyncValueType::INT64_VALUE: displayer::writeNumber(os, buffer, displayer::formatInt(buffer, value.i)); break;
+				case AsyncValueType::UINT64_VALUE: displayer::writeNumber(os, buffer, displayer::formatUint(buffer, value.u)); break;
+				case AsyncValueType::DOUBLE_VALUE: displayer::writeNumber(os, buffer, displayer::formatFloat(buffer, value.d)); break;
+				case AsyncValueType::BOOL_VALUE: os << bool_to_string(value.b); break;
+				default: os << value.s; break;
+				}
+			});
+	}
+
+	size_t size = 2;
+	while (size < capacity) size <<= 1;
+	mask = size - 1;
+	slotList.reset(new Slot[size]);
+	for (size_t i = 0; i < size; ++i) slotList[i].sequence.store(i, std::memory_order_relaxed);
+	consumerThread = std::thread([this]() { consume(); });
+}
+
+AsyncDisplayer::~AsyncDisplayer()
+{
+	bStop.store(true, std::memory_order_release);
+	notifyConsumer();
+	consumerThread.join();
+}
+
+bool AsyncDisplayer::push(DisplayFuncMap displayFuncMap)
+{
+	size_t pos;
+	Slot* pSlot = claimSlot(pos);
+	if (!pSlot) return false;
+	pSlot->bValueRow = false;
+	pSlot->displayFuncMap = std::move(displayFuncMap);
+	publishSlot(*pSlot, pos);
+	return true;
+}
+
+void AsyncDisplayer::flush()
+{
+	size_t pos = enqueuePos.load(std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(mutex);
+	if (flushPos.load(std::memory_order_relaxed) < pos) flushPos.store(pos, std::memory_order_relaxed);
+	consumerCondition.notify_one();
+	flushCondition.wait(lock, [this, pos]() { return displayedPos.load(std::memory_order_acquire) >= pos; });
+}
+
+uint64_t AsyncDisplayer::getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+void AsyncDisplayer::setValue(Value& value, bool b)
+{
+	value.type = AsyncValueType::BOOL_VALUE;
+	value.b = b;
+}
+
+void AsyncDisplayer::setValue(Value& value, const std::string& s)
+{
+	value.type = AsyncValueType::STRING_VALUE;
+	value.s.assign(s);
+}
+
+void AsyncDisplayer::setValue(Value& value, const char* s)
+{
+	value.type = AsyncValueType::STRING_VALUE;
+	value.s.assign(s);
+}
+
+AsyncDisplayer::Slot* AsyncDisplayer::claimSlot(size_t& pos)
+{
+	Slot* pSlot = tryClaimSlot(pos);
+	if (pSlot) return pSlot;
+	if (queueFullPolicy == QueueFullPolicy::DROP
+		|| (queueFullPolicy == QueueFullPolicy::SAMPLE && fullCount.fetch_add(1, std::memory_order_relaxed) % sampleRate != 0))
+	{
+		droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	while (!(pSlot = tryClaimSlot(pos)))
+	{
+		// sleep until the consumer thread frees a slot
+		std::unique_lock<std::mutex> lock(mutex);
+		waitingProducerCount.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // paired with the fence of tryPop
+		slotCondition.wait(lock,
+			[this]()
+			{
+				size_t enqueuedPos = enqueuePos.load(std::memory_order_relaxed);
+				size_t sequence = slotList[enqueuedPos & mask].sequence.load(std::memory_order_acquire);
+				return static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(enqueuedPos) >= 0;
+			});
+		waitingProducerCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return pSlot;
+}
+
+AsyncDisplayer::Slot* AsyncDisplayer::tryClaimSlot(size_t& pos)
+{
+	pos = enqueuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Slot* pSlot = &slotList[pos & mask];
+		size_t sequence = pSlot->sequence.load(std::memory_order_acquire);
+		auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+		if (diff == 0)
+		{
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return pSlot;
+		}
+		else if (diff < 0)
+			return nullptr;
+		else
+			pos = enqueuePos.load(std::memory_order_relaxed);
+	}
+}
+
+void AsyncDisplayer::publishSlot(Slot& slot, size_t pos)
+{
+	slot.sequence.store(pos + 1, std::memory_order_release);
+	// the row is visible before bConsumerSleeping is read (paired with the fence of consume)
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (bConsumerSleeping.load(std::memory_order_relaxed)) notifyConsumer();
+}
+
+bool AsyncDisplayer::tryPop()
+{
+	size_t pos = dequeuePos.load(std::memory_order_relaxed);
+	Slot& slot = slotList[pos & mask];
+	if (slot.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+	// the row is displayed from its slot, the values of pushValues stay in the slot for the next row
+	if (slot.bValueRow)
+	{
+		pDisplayedValueList = &slot.valueList;
+		displayer.display(valueDisplayFuncMap)(os) << rowSuffix;
+	}
+	else
+	{
+		displayer.display(slot.displayFuncMap)(os) << rowSuffix;
+		slot.displayFuncMap.clear();
+	}
+	slot.sequence.store(pos + mask + 1, std::memory_order_release);
+	dequeuePos.store(pos + 1, std::memory_order_relaxed);
+	// the free slot is visible before waitingProducerCount is read (paired with the fence of claimSlot)
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waitingProducerCount.load(std::memory_order_relaxed) != 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		slotCondition.notify_all();
+	}
+	return true;
+}
+
+void AsyncDisplayer::consume()
+{
+	uint32_t idleCount = 0;
+	for (;;)
+	{
+		if (tryPop())
+		{
+			idleCount = 0;
+			// a flush is answered as soon as its rows are displayed, even if the queue is never empty
+			size_t pos = dequeuePos.load(std::memory_order_relaxed);
+			size_t requestedPos = flushPos.load(std::memory_order_relaxed);
+			if (requestedPos > displayedPos.load(std::memory_order_relaxed) && pos >= requestedPos)
+			{
+				os.flush();
+				std::lock_guard<std::mutex> lock(mutex);
+				displayedPos.store(pos, std::memory_order_release);
+				flushCondition.notify_all();
+			}
+			continue;
+		}
+		// queue is empty (or the next slot is being written)
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		if (displayedPos.load(std::memory_order_relaxed) != pos)
+		{
+			os.flush();
+			std::lock_guard<std::mutex> lock(mutex);
+			displayedPos.store(pos, std::memory_order_release);
+			flushCondition.notify_all();
+		}
+		if (bStop.load(std::memory_order_acquire) && pos == enqueuePos.load(std::memory_order_acquire)) break;
+		if (++idleCount < 64)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		// sleep until a row is pushed, a flush is requested or the displayer is stopped
+		std::unique_lock<std::mutex> lock(mutex);
+		bConsumerSleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // paired with the fence of push
+		const Slot& slot = slotList[pos & mask];
+		consumerCondition.wait(lock,
+			[this, &slot, pos]()
+			{
+				return slot.sequence.load(std::memory_order_acquire) == pos + 1 || bStop.load(std::memory_order_acquire)
+					|| flushPos.load(std::memory_order_relaxed) > displayedPos.load(std::memory_order_relaxed);
+			});
+		bConsumerSleeping.store(false, std::memory_order_relaxed);
+		idleCount = 0;
+	}
+}
+
+void AsyncDisplayer::notifyConsumer()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	consumerCondition.notify_one();
+}
+
+#endif // DISPLAYER_IMPLEMENTATION
@@ -0,0 +1,324 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+#include "../Displayer.hpp"
+#include "NumberFormat.hpp"
+
+// type of a field recorded by BinaryRecorder
+enum BinaryFieldType : uint8_t
+{
+	INT64_FIELD,
+	UINT64_FIELD,
+	DOUBLE_FIELD,
+	BOOL_FIELD,
+	STRING_FIELD,
+};
+
+// object used to record rows as binary records, the formatting is deferred to BinaryDecoder
+// the stream must be opened in binary mode, values are written in native endianness
+class BinaryRecorder
+{
+public:
+	// to use like this: BinaryRecorder binaryRecorder(myOfstream)
+	explicit BinaryRecorder(std::ostream& os_, size_t bufferSize_ = 1 << 16);
+
+	// flush the remaining records
+	~BinaryRecorder();
+
+	BinaryRecorder(const BinaryRecorder&) = delete;
+	BinaryRecorder& operator=(const BinaryRecorder&) = delete;
+
+	// schema id derived from the keys of the keyList (displayer keys are ignored)
+	static uint64_t s_getSchemaId(const SL& keyList);
+
+	// register the schema (written once in the stream) and return its id
+	// to use like this: uint64_t schemaId = binaryRecorder.addSchema(myDisplayer)
+	uint64_t addSchema(const SL& keyList);
+
+	// record the values in the same order as the keys of the schema
+	// return false (and record nothing) if the schema is not added or if the number of values is not its number of keys
+	// to use like this: binaryRecorder.record(schemaId, name, age, money)
+	template <typename... Args> bool record(uint64_t schemaId, const Args&... args)
+	{
+		auto it = schemaKeyCountMap.find(schemaId);
+		if (it == schemaKeyCountMap.end() || it->second != sizeof...(Args)) return false;
+		appendRaw('R');
+		appendRaw(schemaId);
+		int expander[] = {0, (appendField(args), 0)...};
+		(void)expander;
+		if (buffer.size() >= bufferSize) flush();
+		return true;
+	}
+
+	void flush();
+
+private:
+	template <typename T> void appendRaw(const T& t)
+	{
+		buffer.append(reinterpret_cast<const char*>(&t), sizeof(T));
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type appendField(const T& t)
+	{
+		appendRaw(BinaryFieldType::INT64_FIELD);
+		appendRaw(static_cast<int64_t>(t));
+	}
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type appendField(const T& t)
+	{
+		appendRaw(BinaryFieldType::UINT64_FIELD);
+		appendRaw(static_cast<uint64_t>(t));
+	}
+
+	template <typename T> typename std::enable_if<std::is_floating_point<T>::value>::type appendField(const T& t)
+	{
+		appendRaw(BinaryFieldType::DOUBLE_FIELD);
+		appendRaw(static_cast<double>(t));
+	}
+
+	void appendField(bool b);
+	void appendField(const std::string& s);
+	void appendField(const char* s);
+	void appendString(const char* s, size_t size);
+
+	std::ostream& os;
+	size_t bufferSize;
+	std::string buffer;
+	std::unordered_map<uint64_t, size_t> schemaKeyCountMap; // number of keys of each added schema
+};
+
+// object used to read the records written by BinaryRecorder
+class BinaryDecoder
+{
+public:
+	// the stream must be opened in binary mode
+	explicit BinaryDecoder(std::istream& is_);
+
+	// the displayFuncMap is only valid during the call
+	using RowCallback = std::function<void(uint64_t schemaId, const DisplayFuncMap& displayFuncMap)>;
+	using SchemaCallback = std::function<void(uint64_t schemaId, const SL& keyList)>;
+
+	// read the records until the end of the stream
+	// return false if the stream is not a valid binary record stream
+	bool decode(const RowCallback& onRow, const SchemaCallback& onSchema = nullptr);
+
+	// return nullptr if the schema has not been read yet
+	const SL* pFindKeyList(uint64_t schemaId) const;
+
+	// type of the field at keyIndex of the last row read with the schema
+	BinaryFieldType getFieldType(uint64_t schemaId, size_t keyIndex) const;
+
+private:
+	struct Field
+	{
+		uint8_t type = BinaryFieldType::STRING_FIELD;
+		union
+		{
+			int64_t i;
+			uint64_t u;
+			double d;
+			bool b;
+		};
+		std::string s;
+	};
+
+	struct Schema
+	{
+		SL keyList;
+		std::vector<Field> fieldList;
+		DisplayFuncMap displayFuncMap; // display the fields of fieldList
+	};
+
+	template <typename T> bool readRaw(T& t)
+	{
+		return static_cast<bool>(is.read(reinterpret_cast<char*>(&t), sizeof(T)));
+	}
+
+	bool readString(std::string& s);
+	bool readField(Field& field);
+
+	std::istream& is;
+	std::unordered_map<uint64_t, std::unique_ptr<Schema>> schemaMap;
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+static const char s_binaryMagic[4] = {'D', 'S', 'P', 'B'};
+
+BinaryRecorder::BinaryRecorder(std::ostream& os_, size_t bufferSize_) : os(os_), bufferSize(bufferSize_)
+{
+	buffer.reserve(bufferSize + 256);
+	buffer.append(s_binaryMagic, sizeof(s_binaryMagic));
+}
+
+BinaryRecorder::~BinaryRecorder() { flush(); }
+
+uint64_t BinaryRecorder::s_getSchemaId(const SL& keyList)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (const auto& key : keyList)
+	{
+		if (displayer::isDisplayerKey(key)) continue;
+		for (char c : key) hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+		hash = (hash ^ 0xFF) * 1099511628211ull; // key separator
+	}
+	return hash;
+}
+
+uint64_t BinaryRecorder::addSchema(const SL& keyList)
+{
+	uint64_t schemaId = s_getSchemaId(keyList);
+	if (schemaKeyCountMap.count(schemaId)) return schemaId;
+	SL dataKeyList;
+	for (const auto& key : keyList)
+		if (!displayer::isDisplayerKey(key)) dataKeyList.push_back(key);
+	schemaKeyCountMap.emplace(schemaId, dataKeyList.size());
+	appendRaw('S');
+	appendRaw(schemaId);
+	appendRaw(static_cast<uint32_t>(dataKeyList.size()));
+	for (const auto& key : dataKeyList)
+	{
+		appendRaw(static_cast<uint32_t>(key.size()));
+		buffer.append(key);
+	}
+	return schemaId;
+}
+
+void BinaryRecorder::flush()
+{
+	os.write(buffer.data(), buffer.size());
+	os.flush();
+	buffer.clear();
+}
+
+void BinaryRecorder::appendField(bool b)
+{
+	appendRaw(BinaryFieldType::BOOL_FIELD);
+	appendRaw(static_cast<uint8_t>(b));
+}
+
+void BinaryRecorder::appendField(const std::string& s) { appendString(s.data(), s.size()); }
+
+void BinaryRecorder::appendField(const char* s) { appendString(s, std::strlen(s)); }
+
+void BinaryRecorder::appendString(const char* s, size_t size)
+{
+	appendRaw(BinaryFieldType::STRING_FIELD);
+	appendRaw(static_cast<uint32_t>(size));
+	buffer.append(s, size);
+}
+
+BinaryDecoder::BinaryDecoder(std::istream& is_) : is(is_) {}
+
+bool BinaryDecoder::decode(const RowCallback& onRow, const SchemaCallback& onSchema)
+{
+	char magic[sizeof(s_binaryMagic)];
+	if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, s_binaryMagic, sizeof(magic)) != 0) return false;
+	char tag;
+	while (is.get(tag))
+	{
+		uint64_t schemaId;
+		if (!readRaw(schemaId)) return false;
+		if (tag == 'S')
+		{
+			uint32_t keyCount;
+			if (!readRaw(keyCount)) return false;
+			std::unique_ptr<Schema> schema(new Schema);
+			schema->keyList.resize(keyCount);
+			for (auto& key : schema->keyList)
+				if (!readString(key)) return false;
+			schema->fieldList.resize(keyCount);
+			for (uint32_t i = 0; i < keyCount; ++i)
+			{
+				const Field* pField = &schema->fieldList[i];
+				schema->displayFuncMap.emplace(schema->keyList[i],
+					DISPLAY_FUNC_LAMBDA(pField) {
+						switch (pField->type)
+						{
+						case BinaryFieldType::INT64_FIELD: os << pField->i; break;
+						case BinaryFieldType::UINT64_FIELD: os << pField->u; break;
+						case BinaryFieldType::DOUBLE_FIELD:
+						{
+							// shortest representation that reads back to the recorded value
+							char buffer[32];
+							displayer::writeNumber(os, buffer, displayer::formatFloat(buffer, pField->d));
+							break;
+						}
+						case BinaryFieldType::BOOL_FIELD: os << bool_to_string(pField->b); break;
+						default: os << pField->s; break;
+						}
+					});
+			}
+			if (onSchema) onSchema(schemaId, schema->keyList);
+			schemaMap[schemaId] = std::move(schema);
+		}
+		else if (tag == 'R')
+		{
+			auto it = schemaMap.find(schemaId);
+			if (it == schemaMap.end()) return false;
+			Schema& schema = *it->second;
+			for (auto& field : schema.fieldList)
+				if (!readField(field)) return false;
+			onRow(schemaId, schema.displayFuncMap);
+		}
+		else
+			return false;
+	}
+	return true;
+}
+
+const SL* BinaryDecoder::pFindKeyList(uint64_t schemaId) const
+{
+	auto it = schemaMap.find(schemaId);
+	return it == schemaMap.end() ? nullptr : &it->second->keyList;
+}
+
+BinaryFieldType BinaryDecoder::getFieldType(uint64_t schemaId, size_t keyIndex) const
+{
+	return static_cast<BinaryFieldType>(schemaMap.at(schemaId)->fieldList.at(keyIndex).type);
+}
+
+bool BinaryDecoder::readString(std::string& s)
+{
+	uint32_t size;
+	if (!readRaw(size)) return false;
+	s.resize(size);
+	return size == 0 || static_cast<bool>(is.read(&s[0], size));
+}
+
+bool BinaryDecoder::readField(Field& field)
+{
+	if (!readRaw(field.type)) return false;
+	switch (field.type)
+	{
+	case BinaryFieldType::INT64_FIELD: return readRaw(field.i);
+	case BinaryFieldType::UINT64_FIELD: return readRaw(field.u);
+	case BinaryFieldType::DOUBLE_FIELD: return readRaw(field.d);
+	case BinaryFieldType::BOOL_FIELD:
+	{
+		uint8_t b;
+		if (!readRaw(b)) return false;
+		field.b = b != 0;
+		return true;
+	}
+	case BinaryFieldType::STRING_FIELD: return readString(field.s);
+	default: return false;
+	}
+}
+
+#endif // DISPLAYER_IMPLEMENTATION
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../Displayer.hpp"
+#include "ColumnAggregator.hpp"
 
 enum BorderFlag : uint8_t
 {
@@ -38,26 +39,37 @@ public:
 	explicit BoxDisplayer(const SL& keyList, uint8_t borderType_);
 
 	OstreamFunc displayHeader();
+	// the footer of columnAggregator is displayed before the bottom border of the last row
+	// columnAggregator is updated by the call (not when the returned OstreamFunc is evaluated)
 	OstreamFunc display(const DisplayFuncMap& displayFuncMap, bool isLast);
 
 	// to use in order to change the categories display
 	void setHeaderDisplayFuncMap(const DisplayFuncMap& headerDisplayFuncMap_);
 
+	// set bDisplayWidthPadding and render the header again with it (for non ASCII keys or cells)
+	// to use like this: boxDisplayer.setDisplayWidthPadding(true)
+	void setDisplayWidthPadding(bool bDisplayWidthPadding_);
+
 	const DisplayFuncMap& getHeaderDisplayFuncMap() const;
 
 	// to use in order to construct a copy
 	// to use like this: BoxDisplayer(oldBoxDisplayer.getBaseKeyList(), newBorderType)
 	const std::vector<std::string>& getBaseKeyList() const;
 
+public:
+	// aggregates displayed as footer rows, updated by display
+	// to use like this: boxDisplayer.columnAggregator.setAggregates(SL{"money"}, AggregateFlag::SUM_AGGREGATE)
+	ColumnAggregator columnAggregator;
+
 protected:
 	using Displayer::display;
 
-private:
 	std::string headerStr;
 	std::string lineStr;
 	std::string splitStr;
 	uint8_t borderType;
 
+private:
 	std::vector<std::string> baseKeyList;
 	DisplayFuncMap headerDisplayFuncMap;
 };
@@ -89,7 +101,7 @@ BoxDisplayer::BoxDisplayer(const SL& keyList, uint8_t borderType_) : borderType(
 		auto& key = keyList[i];
 		push_back(key);
 		baseKeyList.push_back(key);
-		if (globalDisplayFuncMap.count(key)) continue;
+		if (isDisplayerKey(key)) continue;
 		headerDisplayFuncMap_.emplace(key, DisplayFunc(key));
 
 		if (i == lastIndex) continue;
@@ -126,11 +138,23 @@ OstreamFunc BoxDisplayer::displayHeader()
 
 OstreamFunc BoxDisplayer::display(const DisplayFuncMap& displayFuncMap, bool isLast)
 {
+	// updated once per call, even if the returned OstreamFunc is evaluated several times
+	bool bHeader = &displayFuncMap == &headerDisplayFuncMap; // the header is not aggregated
+	if (!columnAggregator.empty() && !bHeader) columnAggregator.update(displayFuncMap);
 	return OSTREAM_FUNC_LAMBDA(this, &displayFuncMap, isLast)
 	{
 		Displayer::display(displayFuncMap)(os);
 		if (isLast)
 		{
+			if (!columnAggregator.empty())
+			{
+				std::string footerSplitStr = splitStr;
+				std::replace_if(
+					footerSplitStr.begin(), footerSplitStr.end(), [](char c) { return c != '|'; }, '=');
+				footerSplitStr[0] = '\n';
+				os << footerSplitStr;
+				for (const auto& footer : columnAggregator.getFooterList(baseKeyList)) Displayer::display(footer)(os << "\n");
+			}
 			if (borderType & BorderFlag::BOTTOM) os << lineStr;
 		}
 		else
@@ -145,15 +169,28 @@ void BoxDisplayer::setHeaderDisplayFuncMap(const DisplayFuncMap& headerDisplayFu
 {
 	headerDisplayFuncMap = headerDisplayFuncMap_;
 	headerStr = display(headerDisplayFuncMap).toString();
-	splitStr = headerStr;
-	std::replace_if(
-		splitStr.begin(), splitStr.end(), [](char c) { return c != '|'; }, '-');
-	lineStr = std::string(headerStr.size(), '-');
+	// borders use the display width of the header (not its size in bytes)
+	splitStr.clear();
+	for (size_t i = 0; i < headerStr.size();)
+	{
+		uint32_t codepoint;
+		i += displayer::decodeUtf8(&headerStr[i], headerStr.size() - i, codepoint);
+		if (codepoint == '|') splitStr += '|';
+		else
+			splitStr.append(displayer::codepointWidth(codepoint), '-');
+	}
+	lineStr = std::string(splitStr.size(), '-');
 	headerStr = "\n" + headerStr;
 	splitStr = "\n" + splitStr;
 	lineStr = "\n" + lineStr;
 }
 
+void BoxDisplayer::setDisplayWidthPadding(bool bDisplayWidthPadding_)
+{
+	bDisplayWidthPadding = bDisplayWidthPadding_;
+	setHeaderDisplayFuncMap(headerDisplayFuncMap);
+}
+
 const DisplayFuncMap& BoxDisplayer::getHeaderDisplayFuncMap() const { return headerDisplayFuncMap; }
 
 const std::vector<std::string>& BoxDisplayer::getBaseKeyList() const { return baseKeyList; }
@@ -0,0 +1,240 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "NumberFormat.hpp"
+
+enum AggregateFlag : uint8_t
+{
+	COUNT_AGGREGATE = 1 << 0,
+	SUM_AGGREGATE = 1 << 1,
+	MIN_AGGREGATE = 1 << 2,
+	MAX_AGGREGATE = 1 << 3,
+	MEAN_AGGREGATE = 1 << 4,
+	VARIANCE_AGGREGATE = 1 << 5,
+	STDDEV_AGGREGATE = 1 << 6,
+};
+
+// aggregates of the numeric values of a column, updated online
+struct ColumnAggregate
+{
+	uint64_t count = 0;
+	double sum = 0;
+	double sumCompensation = 0; // Neumaier compensation of sum
+	double min = std::numeric_limits<double>::infinity();
+	double max = -std::numeric_limits<double>::infinity();
+	double mean = 0;
+	double m2 = 0; // sum of the squared differences to the mean (Welford)
+
+	void add(double value);
+	double getSum() const;
+	double getVariance() const; // sample variance
+	double get(AggregateFlag aggregateFlag) const;
+};
+
+// object that aggregates the cells of some keys while the rows are displayed
+class ColumnAggregator
+{
+public:
+	// aggregate the cells of the keys of keyList, aggregateFlags is a combination of AggregateFlag
+	// mean, variance and stddev are displayed with precision digits after the decimal point
+	// to use like this: setAggregates(SL{PersonKeys.money}, AggregateFlag::SUM_AGGREGATE | AggregateFlag::MEAN_AGGREGATE)
+	void setAggregates(const SL& keyList, uint8_t aggregateFlags_, int precision_ = 2);
+
+	bool empty() const;
+
+	// add the numeric value of the aggregated cells of the row
+	// the value of the number formatters (int_, uint_, fixed_, float_) is used directly
+	// other cells are rendered and added only if the whole cell is a decimal number (like "-12.5e3")
+	// non numeric cells and nan are ignored
+	void update(const DisplayFuncMap& displayFuncMap);
+
+	// return true if s is a decimal number ([+-]digits[.digits][e[+-]digits]) and set value
+	// hexadecimal, inf, nan, grouped digits and trailing characters are rejected
+	static bool s_parseNumber(const std::string& s, double& value);
+
+	// clear the aggregated values (the keys and the flags are kept)
+	void reset();
+
+	// return nullptr if the key is not aggregated
+	const ColumnAggregate* pFind(const std::string& key) const;
+
+	// one row per aggregate flag, with the name of the aggregate (like "sum") in the first key of keyList that is not aggregated
+	// the cells of the other keys of keyList are empty
+	std::vector<DisplayFuncMap> getFooterList(const SL& keyList) const;
+
+	static std::string s_getAggregateName(AggregateFlag aggregateFlag);
+
+private:
+	uint8_t aggregateFlags = 0;
+	int precision = 2;
+	std::vector<std::pair<std::string, ColumnAggregate>> aggregateList;
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+void ColumnAggregate::add(double value)
+{
+	++count;
+	min = std::min(min, value);
+	max = std::max(max, value);
+	if (!std::isfinite(value) || !std::isfinite(sum))
+	{
+		// the compensation and the differences to the mean would be nan, the sum is kept (inf, -inf or nan)
+		sum += value;
+		sumCompensation = 0;
+		mean = sum / static_cast<double>(count);
+		m2 = std::numeric_limits<double>::quiet_NaN();
+		return;
+	}
+	double t = sum + value;
+	sumCompensation += std::fabs(sum) >= std::fabs(value) ? (sum - t) + value : (value - t) + sum;
+	sum = t;
+	double delta = value - mean;
+	mean += delta / static_cast<double>(count);
+	m2 += delta * (value - mean);
+}
+
+double ColumnAggregate::getSum() const { return sum + sumCompensation; }
+
+double ColumnAggregate::getVariance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0; }
+
+double ColumnAggregate::get(AggregateFlag aggregateFlag) const
+{
+	switch (aggregateFlag)
+	{
+	case AggregateFlag::COUNT_AGGREGATE: return static_cast<double>(count);
+	case AggregateFlag::SUM_AGGREGATE: return getSum();
+	case AggregateFlag::MIN_AGGREGATE: return min;
+	case AggregateFlag::MAX_AGGREGATE: return max;
+	case AggregateFlag::MEAN_AGGREGATE: return mean;
+	case AggregateFlag::VARIANCE_AGGREGATE: return getVariance();
+	case AggregateFlag::STDDEV_AGGREGATE: return std::sqrt(getVariance());
+	default: return 0;
+	}
+}
+
+void ColumnAggregator::setAggregates(const SL& keyList, uint8_t aggregateFlags_, int precision_)
+{
+	aggregateFlags = aggregateFlags_;
+	precision = precision_;
+	aggregateList.clear();
+	for (const auto& key : keyList) aggregateList.emplace_back(key, ColumnAggregate());
+}
+
+bool ColumnAggregator::empty() const { return aggregateFlags == 0 || aggregateList.empty(); }
+
+void ColumnAggregator::update(const DisplayFuncMap& displayFuncMap)
+{
+	for (auto& keyAggregate : aggregateList)
+	{
+		auto displayFunc = displayFuncMap.pFind(keyAggregate.first);
+		if (!displayFunc) continue;
+		double value;
+		if (displayFunc->bHasNumericValue) value = displayFunc->numericValue;
+		else if (!s_parseNumber(displayFunc->toString(), value))
+			continue;
+		if (!std::isnan(value)) keyAggregate.second.add(value);
+	}
+}
+
+bool ColumnAggregator::s_parseNumber(const std::string& s, double& value)
+{
+	auto isDigit = [&s](size_t i) { return i < s.size() && s[i] >= '0' && s[i] <= '9'; };
+	size_t i = 0;
+	if (i < s.size() && (s[i] == '-' || s[i] == '+')) ++i;
+	size_t digitCount = 0;
+	for (; isDigit(i); ++i) ++digitCount;
+	if (i < s.size() && s[i] == '.')
+		for (++i; isDigit(i); ++i) ++digitCount;
+	if (digitCount == 0) return false;
+	if (i < s.size() && (s[i] == 'e' || s[i] == 'E'))
+	{
+		++i;
+		if (i < s.size() && (s[i] == '-' || s[i] == '+')) ++i;
+		if (!isDigit(i)) return false;
+		while (isDigit(i)) ++i;
+	}
+	if (i != s.size()) return false;
+	// the grammar is checked above, strtod only converts (it must read the whole string, whatever the locale)
+	char* end;
+	value = std::strtod(s.c_str(), &end);
+	return end == s.c_str() + s.size();
+}
+
+void ColumnAggregator::reset()
+{
+	for (auto& keyAggregate : aggregateList) keyAggregate.second = ColumnAggregate();
+}
+
+const ColumnAggregate* ColumnAggregator::pFind(const std::string& key) const
+{
+	for (const auto& keyAggregate : aggregateList)
+		if (keyAggregate.first == key) return &keyAggregate.second;
+	return nullptr;
+}
+
+std::vector<DisplayFuncMap> ColumnAggregator::getFooterList(const SL& keyList) const
+{
+	// the label is displayed in the first key that is not aggregated
+	std::string labelKey;
+	for (const auto& key : keyList)
+		if (!displayer::isDisplayerKey(key) && !pFind(key))
+		{
+			labelKey = key;
+			break;
+		}
+
+	std::vector<DisplayFuncMap> result;
+	for (uint8_t flag = AggregateFlag::COUNT_AGGREGATE; flag != 0 && flag <= AggregateFlag::STDDEV_AGGREGATE; flag <<= 1)
+	{
+		if (!(aggregateFlags & flag)) continue;
+		auto aggregateFlag = static_cast<AggregateFlag>(flag);
+		DisplayFuncMap footer;
+		for (const auto& key : keyList)
+		{
+			if (displayer::isDisplayerKey(key)) continue;
+			auto pAggregate = pFind(key);
+			if (pAggregate && aggregateFlag == AggregateFlag::COUNT_AGGREGATE) footer.emplace(key, displayer::uint_(pAggregate->count));
+			else if (pAggregate && pAggregate->count != 0)
+			{
+				double value = pAggregate->get(aggregateFlag);
+				bool bFixed = aggregateFlag & (MEAN_AGGREGATE | VARIANCE_AGGREGATE | STDDEV_AGGREGATE);
+				footer.emplace(key, bFixed ? displayer::fixed_(value, precision) : displayer::float_(value));
+			}
+			else if (key == labelKey)
+				footer.emplace(key, DisplayFunc(s_getAggregateName(aggregateFlag)));
+			else
+				footer.emplace(key, DisplayFunc(std::string()));
+		}
+		result.push_back(footer);
+	}
+	return result;
+}
+
+std::string ColumnAggregator::s_getAggregateName(AggregateFlag aggregateFlag)
+{
+	switch (aggregateFlag)
+	{
+	case AggregateFlag::COUNT_AGGREGATE: return "count";
+	case AggregateFlag::SUM_AGGREGATE: return "sum";
+	case AggregateFlag::MIN_AGGREGATE: return "min";
+	case AggregateFlag::MAX_AGGREGATE: return "max";
+	case AggregateFlag::MEAN_AGGREGATE: return "mean";
+	case AggregateFlag::VARIANCE_AGGREGATE: return "variance";
+	case AggregateFlag::STDDEV_AGGREGATE: return "stddev";
+	default: return "";
+	}
+}
+
+#endif // DISPLAYER_IMPLEMENTATION
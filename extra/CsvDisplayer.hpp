@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../Displayer.hpp"
+#include "ColumnAggregator.hpp"
 
 class CsvDisplayer : public Displayer
 {
@@ -11,6 +12,16 @@ public:
 	// to use like this: CsvDisplayer(SL{"myStr1", "myStr2"})
 	explicit CsvDisplayer(const SL& keyList);
 
+	// the separator is written between the cells (", " by default)
+	// to use like this: CsvDisplayer(SL{"myStr1", "myStr2"}, ",")
+	CsvDisplayer(const SL& keyList, const std::string& separator);
+
+	// display the object, columnAggregator is updated by the call (except for headerDisplayFuncMap)
+	OstreamFunc display(const DisplayFuncMap& displayFuncMap);
+
+	// display the rows of columnAggregator (nothing if there is no aggregate)
+	OstreamFunc displayFooter();
+
 	// to use in order to construct a copy
 	// to use like this: CsvDisplayer(oldCsvDisplayer.getBaseKeyList())
 	const std::vector<std::string>& getBaseKeyList() const;
@@ -18,10 +29,20 @@ public:
 public:
 	DisplayFuncMap headerDisplayFuncMap;
 
+	// aggregates displayed by displayFooter, updated by display
+	// to use like this: csvDisplayer.columnAggregator.setAggregates(SL{"money"}, AggregateFlag::SUM_AGGREGATE)
+	ColumnAggregator columnAggregator;
+
 private:
 	std::vector<std::string> baseKeyList;
 };
 
+namespace displayer
+{
+	// write s as a csv cell, in quotes (with "" for the quotes of s) if s contains the delimiter, a quote or a newline
+	void writeCsvQuoted(std::ostream& os, const char* s, size_t size, char delimiter = ',');
+} // namespace displayer
+
 // ============================================================
 // ============================================================
 // ===================== Implementations ======================
@@ -30,20 +51,69 @@ private:
 
 #ifdef DISPLAYER_IMPLEMENTATION
 
-CsvDisplayer::CsvDisplayer(const SL& keyList)
+CsvDisplayer::CsvDisplayer(const SL& keyList) : CsvDisplayer(keyList, ", ") {}
+
+CsvDisplayer::CsvDisplayer(const SL& keyList, const std::string& separator)
 {
 	using namespace displayer;
 	for (const auto& key : keyList)
 	{
 		baseKeyList.push_back(key);
-		if (globalDisplayFuncMap.count(key)) continue;
+		if (isDisplayerKey(key)) continue;
 		push_back(key);
 		headerDisplayFuncMap.emplace(key, DisplayFunc(key));
-		push_back(string_(", "));
+		push_back(string_(separator));
 	}
-	if (!globalDisplayFuncMap.count(keyList.back())) pop_back();
+	if (!isDisplayerKey(keyList.back())) pop_back();
+}
+
+OstreamFunc CsvDisplayer::display(const DisplayFuncMap& displayFuncMap)
+{
+	// updated once per call, even if the returned OstreamFunc is evaluated several times
+	bool bHeader = &displayFuncMap == &headerDisplayFuncMap; // the header is not aggregated
+	if (!columnAggregator.empty() && !bHeader) columnAggregator.update(displayFuncMap);
+	return Displayer::display(displayFuncMap);
+}
+
+OstreamFunc CsvDisplayer::displayFooter()
+{
+	return OSTREAM_FUNC_LAMBDA(this)
+	{
+		if (columnAggregator.empty()) return os;
+		bool isFirst = true;
+		for (const auto& footer : columnAggregator.getFooterList(baseKeyList))
+		{
+			if (!isFirst) os << "\n";
+			isFirst = false;
+			Displayer::display(footer)(os);
+		}
+		return os;
+	};
 }
 
 const std::vector<std::string>& CsvDisplayer::getBaseKeyList() const { return baseKeyList; }
 
+namespace displayer
+{
+	void writeCsvQuoted(std::ostream& os, const char* s, size_t size, char delimiter)
+	{
+		bool bQuote = false;
+		for (const char* c = s; c < s + size && !bQuote; ++c) bQuote = *c == delimiter || *c == '"' || *c == '\n' || *c == '\r';
+		if (!bQuote)
+		{
+			os.write(s, size);
+			return;
+		}
+		os << '"';
+		const char* begin = s;
+		for (const char* c = s; c < s + size; ++c)
+		{
+			if (*c != '"') continue;
+			os.write(begin, c + 1 - begin) << '"';
+			begin = c + 1;
+		}
+		os.write(begin, s + size - begin) << '"';
+	}
+} // namespace displayer
+
 #endif // DISPLAYER_IMPLEMENTATION
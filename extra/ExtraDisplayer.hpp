@@ -32,7 +32,7 @@ ExtraDisplayer::ExtraDisplayer(const SL& keyList)
 	for (const auto& key : keyList)
 	{
 		push_back(key);
-		if (displayer::globalDisplayFuncMap.count(key)) continue;
+		if (displayer::isDisplayerKey(key)) continue;
 		headerDisplayFuncMap.emplace(key, DisplayFunc(key));
 	}
 }
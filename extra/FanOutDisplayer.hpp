@@ -0,0 +1,143 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include "../Displayer.hpp"
+
+// object that evaluates each cell of a row once and sends the row to several sinks
+// the cells are evaluated in a scratch buffer with the default format of a stream (no width, no std::hex...)
+// then each sink displays them with its own displayer (the width and the alignment of the displayer are applied)
+class FanOutDisplayer
+{
+public:
+	// the sink displays the row made of the evaluated cells, the row is only valid during the call
+	using RowSink = std::function<void(const DisplayFuncMap& displayFuncMap)>;
+
+	FanOutDisplayer();
+
+	FanOutDisplayer(const FanOutDisplayer&) = delete;
+	FanOutDisplayer& operator=(const FanOutDisplayer&) = delete;
+
+	// the keys of the displayer are evaluated for all the sinks
+	// to use like this: fanOutDisplayer.addSink(csvDisplayer, [&](const DisplayFuncMap& row) { ofs << csvDisplayer.display(row) << "\n"; })
+	void addSink(const Displayer& displayer, const RowSink& rowSink);
+
+	// evaluate the cells of the row once, then call every sink
+	void display(const DisplayFuncMap& displayFuncMap);
+
+private:
+	// streambuf that appends to scratch
+	class ScratchStreambuf : public std::streambuf
+	{
+	public:
+		explicit ScratchStreambuf(std::string& scratch_);
+
+	protected:
+		int_type overflow(int_type c) override;
+		std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+	private:
+		std::string& scratch;
+	};
+
+	struct Cell
+	{
+		std::string key;
+		size_t offset = 0;
+		size_t size = 0;
+		bool bInRow = false;				  // true if the cell is in cachedDisplayFuncMap
+		DisplayFunc* pDisplayFunc = nullptr; // DisplayFunc of the cell in cachedDisplayFuncMap (if bInRow)
+	};
+
+	DisplayFunc getCellDisplayFunc(size_t cellIndex) const;
+
+	std::vector<RowSink> rowSinkList;
+	std::vector<Cell> cellList; // one cell per key referenced by a sink
+	std::string scratch;
+	ScratchStreambuf scratchStreambuf;
+	std::ostream scratchOs;
+	DisplayFuncMap cachedDisplayFuncMap; // DisplayFunc of the cells, reused for each row
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+FanOutDisplayer::ScratchStreambuf::ScratchStreambuf(std::string& scratch_) : scratch(scratch_) {}
+
+FanOutDisplayer::ScratchStreambuf::int_type FanOutDisplayer::ScratchStreambuf::overflow(int_type c)
+{
+	if (!traits_type::eq_int_type(c, traits_type::eof())) scratch += traits_type::to_char_type(c);
+	return traits_type::not_eof(c);
+}
+
+std::streamsize FanOutDisplayer::ScratchStreambuf::xsputn(const char* s, std::streamsize n)
+{
+	scratch.append(s, static_cast<size_t>(n));
+	return n;
+}
+
+FanOutDisplayer::FanOutDisplayer() : scratchStreambuf(scratch), scratchOs(&scratchStreambuf) {}
+
+void FanOutDisplayer::addSink(const Displayer& displayer, const RowSink& rowSink)
+{
+	rowSinkList.push_back(rowSink);
+	for (const auto& key : displayer)
+	{
+		if (displayer::isDisplayerKey(key)) continue;
+		auto it = std::find_if(cellList.begin(), cellList.end(), [&key](const Cell& cell) { return cell.key == key; });
+		if (it != cellList.end()) continue;
+		Cell cell;
+		cell.key = key;
+		cellList.push_back(cell);
+	}
+}
+
+void FanOutDisplayer::display(const DisplayFuncMap& displayFuncMap)
+{
+	scratch.clear();
+	for (size_t i = 0; i < cellList.size(); ++i)
+	{
+		Cell& cell = cellList[i];
+		auto displayFunc = displayFuncMap.pFind(cell.key);
+		if (!displayFunc)
+		{
+			if (cell.bInRow) cachedDisplayFuncMap.erase(cell.key);
+			cell.bInRow = false;
+			cell.pDisplayFunc = nullptr;
+			continue;
+		}
+		cell.offset = scratch.size();
+		(*displayFunc)(scratchOs);
+		// restore the default format for the next cell
+		scratchOs.flags(std::ios_base::dec | std::ios_base::skipws);
+		scratchOs.fill(' ');
+		scratchOs.precision(6);
+		scratchOs.width(0);
+		scratchOs.clear(); // an error of the cell does not silence the next ones
+		cell.size = scratch.size() - cell.offset;
+		if (!cell.bInRow) cell.pDisplayFunc = &cachedDisplayFuncMap.emplace(cell.key, getCellDisplayFunc(i)).first->second;
+		cell.bInRow = true;
+		// the value of the number formatters is kept, to be aggregated by the sinks
+		cell.pDisplayFunc->bHasNumericValue = displayFunc->bHasNumericValue;
+		cell.pDisplayFunc->numericValue = displayFunc->numericValue;
+	}
+	for (const auto& rowSink : rowSinkList) rowSink(cachedDisplayFuncMap);
+}
+
+DisplayFunc FanOutDisplayer::getCellDisplayFunc(size_t cellIndex) const
+{
+	DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(this, cellIndex)
+	{
+		const Cell& cell = cellList[cellIndex];
+		displayer::writePadded(os, scratch.data() + cell.offset, cell.size);
+	};
+	displayFunc.bAppliesWidth = true;
+	return displayFunc;
+}
+
+#endif // DISPLAYER_IMPLEMENTATION
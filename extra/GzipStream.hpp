@@ -0,0 +1,712 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "../Displayer.hpp"
+
+// deflate (RFC 1951) encoder: LZ77 on a 32 KB window with hash chains
+// each block is written with the smallest of dynamic Huffman codes, fixed Huffman codes or no compression
+// the encoder keeps its window between the calls, so the data can be compressed block by block
+class DeflateEncoder
+{
+public:
+	// maxChainLength is the maximum number of previous positions compared to find a match (speed / ratio trade-off)
+	explicit DeflateEncoder(uint32_t maxChainLength_ = 32);
+
+	// append to out a block compressing the data (not final, out is not byte aligned)
+	void compress(const char* data, size_t size, std::string& out);
+
+	// append to out an empty stored block, then out is byte aligned and can be decoded up to there
+	void syncFlush(std::string& out);
+
+	// append to out the final block, then out is byte aligned
+	// the encoder is reset for a new stream
+	void finish(std::string& out);
+
+private:
+	static constexpr size_t s_windowSize = 1 << 15;
+	static constexpr size_t s_hashSize = 1 << 15;
+	static constexpr size_t s_minMatch = 3;
+	static constexpr size_t s_maxMatch = 258;
+
+	// literal if length is 0, else match of length bytes at distance value
+	struct Token
+	{
+		uint16_t length;
+		uint16_t value;
+	};
+
+	// write tokenList as a block, data is the input of the block
+	void writeBlock(const uint8_t* data, size_t size, std::string& out);
+	void writeTokens(const uint16_t* literalCodeList,
+		const uint8_t* literalLengthList,
+		const uint16_t* distanceCodeList,
+		const uint8_t* distanceLengthList,
+		std::string& out);
+	void writeBits(uint32_t value, uint32_t bitCount, std::string& out);
+	void alignToByte(std::string& out);
+	static uint32_t s_hash(const uint8_t* p);
+
+	uint32_t maxChainLength;
+	std::string window;		  // last bytes of the stream, window[0] is at position windowStart
+	uint64_t windowStart = 0; // position of window[0] in the stream
+	std::vector<uint64_t> headList; // last position + 1 of each hash (0 for none)
+	std::vector<uint64_t> prevList; // previous position + 1 of the same hash, indexed by position % s_windowSize
+	std::vector<Token> tokenList; // tokens of the current block
+	uint64_t bitBuffer = 0;
+	uint32_t bitCount = 0;
+};
+
+// streambuf that compresses what is written in gzip format (RFC 1952) to os
+// the data is compressed by blocks of blockSize bytes, in a worker thread if bThreaded
+// to use like this: GzipStreambuf gzipStreambuf(ofs); std::ostream gzipOs(&gzipStreambuf); gzipOs << csvDisplayer.display(row)
+class GzipStreambuf : public std::streambuf
+{
+public:
+	// os must outlive the GzipStreambuf
+	explicit GzipStreambuf(std::ostream& os_, bool bThreaded = false, size_t blockSize = 1 << 16, uint32_t maxChainLength = 32);
+
+	// finish the stream
+	~GzipStreambuf() override;
+
+	GzipStreambuf(const GzipStreambuf&) = delete;
+	GzipStreambuf& operator=(const GzipStreambuf&) = delete;
+
+	// write the remaining data and the gzip trailer to os, nothing can be written after
+	void finish();
+
+protected:
+	int_type overflow(int_type c) override;
+	std::streamsize xsputn(const char* s, std::streamsize n) override;
+	// compress the pending data and flush os, the output written so far can be decompressed
+	int sync() override;
+
+private:
+	// give the put area to the compression (in the worker thread if any)
+	void submit();
+	// wait until the worker thread is idle
+	void wait();
+	void compressBlock(const char* data, size_t size);
+	void writeOutput();
+	void work();
+
+	std::ostream& os;
+	DeflateEncoder deflateEncoder;
+	uint32_t crc = 0;
+	uint32_t inputSize = 0; // modulo 2^32
+	std::string output;
+	std::vector<char> putBuffer;
+	bool bFinished = false;
+
+	std::vector<char> workBuffer; // block compressed by the worker thread
+	size_t workSize = 0;
+	bool bWorkPending = false;
+	bool bStop = false;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread workerThread;
+};
+
+// ostream that writes to a GzipStreambuf
+// to use like this: GzipOstream gzipOs(ofs); gzipOs << csvDisplayer.display(row) << "\n";
+class GzipOstream : public std::ostream
+{
+public:
+	explicit GzipOstream(std::ostream& os, bool bThreaded = false, size_t blockSize = 1 << 16, uint32_t maxChainLength = 32);
+
+	// write the remaining data and the gzip trailer, nothing can be written after
+	void finish();
+
+private:
+	GzipStreambuf gzipStreambuf;
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+namespace displayer
+{
+	static const uint16_t s_lengthBaseList[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163,
+		195, 227, 258};
+	static const uint8_t s_lengthExtraList[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+	static const uint16_t s_distanceBaseList[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049,
+		3073, 4097, 6145, 8193, 12289, 16385, 24577};
+	static const uint8_t s_distanceExtraList[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+	// order of the code lengths of the code length alphabet in a dynamic block header
+	static const uint8_t s_codeLengthOrderList[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+	static uint32_t s_reverseBits(uint32_t code, uint32_t length)
+	{
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < length; ++i) result |= ((code >> i) & 1) << (length - 1 - i);
+		return result;
+	}
+
+	// canonical Huffman codes of the lengths, reversed to be written from the least significant bit
+	static void s_buildCodes(const uint8_t* lengthList, size_t count, uint16_t* codeList)
+	{
+		uint16_t lengthCountList[16] = {0};
+		for (size_t i = 0; i < count; ++i) ++lengthCountList[lengthList[i]];
+		lengthCountList[0] = 0;
+		uint16_t nextCodeList[16] = {0};
+		uint32_t code = 0;
+		for (int length = 1; length < 16; ++length)
+		{
+			code = (code + lengthCountList[length - 1]) << 1;
+			nextCodeList[length] = static_cast<uint16_t>(code);
+		}
+		for (size_t i = 0; i < count; ++i)
+			codeList[i] = lengthList[i] == 0 ? 0 : static_cast<uint16_t>(s_reverseBits(nextCodeList[lengthList[i]]++, lengthList[i]));
+	}
+
+	// Huffman code lengths of the frequencies, limited to maxLength (the frequencies are halved until the limit is respected)
+	static void s_buildCodeLengths(const uint32_t* frequencyList, size_t count, uint8_t maxLength, uint8_t* lengthList)
+	{
+		std::fill(lengthList, lengthList + count, static_cast<uint8_t>(0));
+		std::vector<uint32_t> weightList(frequencyList, frequencyList + count);
+		using Node = std::pair<uint64_t, size_t>; // weight, index (leaves first, then internal nodes)
+		for (;;)
+		{
+			std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+			for (size_t i = 0; i < count; ++i)
+				if (weightList[i] != 0) queue.push(Node(weightList[i], i));
+			if (queue.empty()) return;
+			if (queue.size() == 1)
+			{
+				// a code of a single symbol is not complete: add a second symbol
+				size_t index = queue.top().second;
+				lengthList[index] = 1;
+				lengthList[index == 0 ? 1 : 0] = 1;
+				return;
+			}
+			std::vector<size_t> parentList(count, 0);
+			while (queue.size() > 1)
+			{
+				Node a = queue.top();
+				queue.pop();
+				Node b = queue.top();
+				queue.pop();
+				size_t node = parentList.size();
+				parentList.push_back(0);
+				parentList[a.second] = node;
+				parentList[b.second] = node;
+				queue.push(Node(a.first + b.first, node));
+			}
+			size_t root = parentList.size() - 1;
+			bool bTooLong = false;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (weightList[i] == 0) continue;
+				uint32_t length = 0;
+				for (size_t node = i; node != root; node = parentList[node]) ++length;
+				if (length > maxLength) bTooLong = true;
+				lengthList[i] = static_cast<uint8_t>(length);
+			}
+			if (!bTooLong) return;
+			for (auto& weight : weightList)
+				if (weight != 0) weight = std::max(weight >> 1, 1u);
+		}
+	}
+
+	// symbol of the lengths and the distances, and the fixed Huffman codes
+	struct DeflateTables
+	{
+		uint8_t lengthIndexList[259];	  // length -> index in s_lengthBaseList
+		uint8_t distanceCodeList[512];	  // distance - 1 (< 256) or 256 + (distance - 1) / 128 -> distance code
+		uint8_t fixedLiteralLengthList[288];
+		uint16_t fixedLiteralCodeList[288];
+		uint8_t fixedDistanceLengthList[30];
+		uint16_t fixedDistanceCodeList[30];
+
+		DeflateTables()
+		{
+			for (uint8_t index = 0; index < 29; ++index)
+			{
+				uint32_t end = index + 1 < 29 ? s_lengthBaseList[index + 1] : 259;
+				for (uint32_t length = s_lengthBaseList[index]; length < end; ++length) lengthIndexList[length] = index;
+			}
+			for (uint8_t code = 0; code < 30; ++code)
+			{
+				uint32_t end = code + 1 < 30 ? s_distanceBaseList[code + 1] : 32769;
+				for (uint32_t distance = s_distanceBaseList[code]; distance < end; ++distance)
+				{
+					uint32_t d = distance - 1;
+					distanceCodeList[d < 256 ? d : 256 + (d >> 7)] = code;
+				}
+			}
+			for (size_t symbol = 0; symbol < 288; ++symbol)
+				fixedLiteralLengthList[symbol] = symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8;
+			s_buildCodes(fixedLiteralLengthList, 288, fixedLiteralCodeList);
+			std::fill(fixedDistanceLengthList, fixedDistanceLengthList + 30, static_cast<uint8_t>(5));
+			s_buildCodes(fixedDistanceLengthList, 30, fixedDistanceCodeList);
+		}
+
+		uint8_t getDistanceCode(size_t distance) const
+		{
+			size_t d = distance - 1;
+			return distanceCodeList[d < 256 ? d : 256 + (d >> 7)];
+		}
+	};
+
+	static const DeflateTables& s_deflateTables()
+	{
+		static const DeflateTables deflateTables;
+		return deflateTables;
+	}
+
+	static uint32_t s_crc32(uint32_t crc, const char* data, size_t size)
+	{
+		static const struct CrcTable
+		{
+			uint32_t valueList[256];
+			CrcTable()
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					uint32_t value = i;
+					for (int bit = 0; bit < 8; ++bit) value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+					valueList[i] = value;
+				}
+			}
+		} s_crcTable;
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i) crc = s_crcTable.valueList[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+} // namespace displayer
+
+constexpr size_t DeflateEncoder::s_windowSize;
+constexpr size_t DeflateEncoder::s_hashSize;
+constexpr size_t DeflateEncoder::s_minMatch;
+constexpr size_t DeflateEncoder::s_maxMatch;
+
+DeflateEncoder::DeflateEncoder(uint32_t maxChainLength_) :
+	maxChainLength(maxChainLength_), headList(s_hashSize, 0), prevList(s_windowSize, 0)
+{
+}
+
+void DeflateEncoder::compress(const char* data, size_t size, std::string& out)
+{
+	if (size == 0) return;
+	size_t pos = window.size(); // index in window of the first byte to encode
+	window.append(data, size);
+	auto p = reinterpret_cast<const uint8_t*>(window.data());
+	size_t end = window.size();
+
+	tokenList.clear();
+	while (pos < end)
+	{
+		size_t bestLength = 0;
+		size_t bestDistance = 0;
+		uint32_t hash = 0;
+		if (pos + s_minMatch <= end)
+		{
+			hash = s_hash(p + pos);
+			uint64_t absolutePos = windowStart + pos;
+			size_t maxLength = std::min(s_maxMatch, end - pos);
+			uint64_t candidate = headList[hash];
+			for (uint32_t chain = 0; candidate != 0 && chain < maxChainLength; ++chain)
+			{
+				uint64_t candidatePos = candidate - 1;
+				if (candidatePos < windowStart || absolutePos - candidatePos > s_windowSize) break;
+				const uint8_t* a = p + (candidatePos - windowStart);
+				const uint8_t* b = p + pos;
+				if (bestLength == 0 || a[bestLength] == b[bestLength])
+				{
+					size_t length = 0;
+					while (length < maxLength && a[length] == b[length]) ++length;
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = static_cast<size_t>(absolutePos - candidatePos);
+						if (length == maxLength) break;
+					}
+				}
+				candidate = prevList[candidatePos % s_windowSize];
+			}
+		}
+
+		size_t step = bestLength >= s_minMatch ? bestLength : 1;
+		if (step == 1) tokenList.push_back(Token{0, p[pos]});
+		else
+			tokenList.push_back(Token{static_cast<uint16_t>(bestLength), static_cast<uint16_t>(bestDistance)});
+
+		// insert the hash of every encoded position
+		for (size_t i = pos; i < pos + step && i + s_minMatch <= end; ++i)
+		{
+			uint32_t h = i == pos ? hash : s_hash(p + i);
+			uint64_t absolutePos = windowStart + i;
+			prevList[absolutePos % s_windowSize] = headList[h];
+			headList[h] = absolutePos + 1;
+		}
+		pos += step;
+	}
+	writeBlock(p + end - size, size, out);
+
+	// only keep the window
+	if (window.size() > 2 * s_windowSize)
+	{
+		size_t eraseSize = window.size() - s_windowSize;
+		window.erase(0, eraseSize);
+		windowStart += eraseSize;
+	}
+}
+
+void DeflateEncoder::syncFlush(std::string& out)
+{
+	writeBits(0, 3, out); // not final, stored
+	alignToByte(out);
+	out.append("\x00\x00\xFF\xFF", 4);
+}
+
+void DeflateEncoder::finish(std::string& out)
+{
+	const auto& deflateTables = displayer::s_deflateTables();
+	writeBits(0x3, 3, out); // final, fixed Huffman
+	writeBits(deflateTables.fixedLiteralCodeList[256], deflateTables.fixedLiteralLengthList[256], out);
+	alignToByte(out);
+	window.clear();
+	windowStart = 0;
+	std::fill(headList.begin(), headList.end(), 0);
+	std::fill(prevList.begin(), prevList.end(), 0);
+}
+
+void DeflateEncoder::writeBlock(const uint8_t* data, size_t size, std::string& out)
+{
+	const auto& deflateTables = displayer::s_deflateTables();
+
+	uint32_t literalFrequencyList[286] = {0};
+	uint32_t distanceFrequencyList[30] = {0};
+	uint64_t extraBitCount = 0;
+	for (const auto& token : tokenList)
+	{
+		if (token.length == 0)
+		{
+			++literalFrequencyList[token.value];
+			continue;
+		}
+		uint8_t lengthIndex = deflateTables.lengthIndexList[token.length];
+		uint8_t distanceCode = deflateTables.getDistanceCode(token.value);
+		++literalFrequencyList[257 + lengthIndex];
+		++distanceFrequencyList[distanceCode];
+		extraBitCount += displayer::s_lengthExtraList[lengthIndex] + displayer::s_distanceExtraList[distanceCode];
+	}
+	literalFrequencyList[256] = 1; // end of block
+
+	// dynamic Huffman codes
+	uint8_t literalLengthList[286];
+	uint8_t distanceLengthList[30];
+	displayer::s_buildCodeLengths(literalFrequencyList, 286, 15, literalLengthList);
+	displayer::s_buildCodeLengths(distanceFrequencyList, 30, 15, distanceLengthList);
+	size_t literalCount = 286;
+	while (literalCount > 257 && literalLengthList[literalCount - 1] == 0) --literalCount;
+	size_t distanceCount = 30;
+	while (distanceCount > 1 && distanceLengthList[distanceCount - 1] == 0) --distanceCount;
+
+	// code lengths of the two codes, run length encoded with the symbols 16 (repeat), 17 and 18 (zeros)
+	std::vector<uint8_t> lengthList(literalLengthList, literalLengthList + literalCount);
+	lengthList.insert(lengthList.end(), distanceLengthList, distanceLengthList + distanceCount);
+	std::vector<std::pair<uint8_t, uint8_t>> codeLengthSymbolList; // symbol, extra bits value
+	uint32_t codeLengthFrequencyList[19] = {0};
+	for (size_t i = 0; i < lengthList.size();)
+	{
+		uint8_t length = lengthList[i];
+		size_t runLength = 1;
+		while (i + runLength < lengthList.size() && lengthList[i + runLength] == length) ++runLength;
+		i += runLength;
+		if (length == 0)
+		{
+			while (runLength >= 11)
+			{
+				auto repeat = std::min(runLength, static_cast<size_t>(138));
+				codeLengthSymbolList.emplace_back(18, static_cast<uint8_t>(repeat - 11));
+				runLength -= repeat;
+			}
+			if (runLength >= 3)
+			{
+				codeLengthSymbolList.emplace_back(17, static_cast<uint8_t>(runLength - 3));
+				runLength = 0;
+			}
+		}
+		else
+		{
+			codeLengthSymbolList.emplace_back(length, 0);
+			--runLength;
+			while (runLength >= 3)
+			{
+				auto repeat = std::min(runLength, static_cast<size_t>(6));
+				codeLengthSymbolList.emplace_back(16, static_cast<uint8_t>(repeat - 3));
+				runLength -= repeat;
+			}
+		}
+		for (; runLength > 0; --runLength) codeLengthSymbolList.emplace_back(length, 0);
+	}
+	for (const auto& symbol : codeLengthSymbolList) ++codeLengthFrequencyList[symbol.first];
+	uint8_t codeLengthLengthList[19];
+	displayer::s_buildCodeLengths(codeLengthFrequencyList, 19, 7, codeLengthLengthList);
+	size_t codeLengthCount = 19;
+	while (codeLengthCount > 4 && codeLengthLengthList[displayer::s_codeLengthOrderList[codeLengthCount - 1]] == 0) --codeLengthCount;
+
+	// size of the block for each type
+	uint64_t dynamicBitCount = 3 + 5 + 5 + 4 + 3 * codeLengthCount + extraBitCount;
+	uint64_t fixedBitCount = 3 + extraBitCount;
+	for (const auto& symbol : codeLengthSymbolList)
+		dynamicBitCount += codeLengthLengthList[symbol.first] + (symbol.first == 16 ? 2 : symbol.first == 17 ? 3 : symbol.first == 18 ? 7 : 0);
+	for (size_t i = 0; i < 286; ++i)
+	{
+		dynamicBitCount += static_cast<uint64_t>(literalFrequencyList[i]) * literalLengthList[i];
+		fixedBitCount += static_cast<uint64_t>(literalFrequencyList[i]) * deflateTables.fixedLiteralLengthList[i];
+	}
+	for (size_t i = 0; i < 30; ++i)
+	{
+		dynamicBitCount += static_cast<uint64_t>(distanceFrequencyList[i]) * distanceLengthList[i];
+		fixedBitCount += static_cast<uint64_t>(distanceFrequencyList[i]) * 5;
+	}
+	uint64_t storedBitCount = ((size + 65534) / 65535) * (3 + 7 + 32) + static_cast<uint64_t>(size) * 8;
+
+	if (storedBitCount < dynamicBitCount && storedBitCount < fixedBitCount)
+	{
+		for (size_t offset = 0; offset < size; offset += 65535)
+		{
+			auto chunkSize = static_cast<uint32_t>(std::min(size - offset, static_cast<size_t>(65535)));
+			writeBits(0, 3, out); // not final, stored
+			alignToByte(out);
+			writeBits(chunkSize, 16, out);
+			writeBits(~chunkSize & 0xFFFF, 16, out);
+			out.append(reinterpret_cast<const char*>(data + offset), chunkSize);
+		}
+		return;
+	}
+
+	if (fixedBitCount <= dynamicBitCount)
+	{
+		writeBits(0x2, 3, out); // not final, fixed Huffman
+		writeTokens(deflateTables.fixedLiteralCodeList,
+			deflateTables.fixedLiteralLengthList,
+			deflateTables.fixedDistanceCodeList,
+			deflateTables.fixedDistanceLengthList,
+			out);
+		return;
+	}
+
+	writeBits(0x4, 3, out); // not final, dynamic Huffman
+	writeBits(static_cast<uint32_t>(literalCount - 257), 5, out);
+	writeBits(static_cast<uint32_t>(distanceCount - 1), 5, out);
+	writeBits(static_cast<uint32_t>(codeLengthCount - 4), 4, out);
+	for (size_t i = 0; i < codeLengthCount; ++i) writeBits(codeLengthLengthList[displayer::s_codeLengthOrderList[i]], 3, out);
+	uint16_t codeLengthCodeList[19];
+	displayer::s_buildCodes(codeLengthLengthList, 19, codeLengthCodeList);
+	for (const auto& symbol : codeLengthSymbolList)
+	{
+		writeBits(codeLengthCodeList[symbol.first], codeLengthLengthList[symbol.first], out);
+		if (symbol.first >= 16) writeBits(symbol.second, symbol.first == 16 ? 2 : symbol.first == 17 ? 3 : 7, out);
+	}
+	uint16_t literalCodeList[286];
+	uint16_t distanceCodeList[30];
+	displayer::s_buildCodes(literalLengthList, 286, literalCodeList);
+	displayer::s_buildCodes(distanceLengthList, 30, distanceCodeList);
+	writeTokens(literalCodeList, literalLengthList, distanceCodeList, distanceLengthList, out);
+}
+
+void DeflateEncoder::writeTokens(const uint16_t* literalCodeList,
+	const uint8_t* literalLengthList,
+	const uint16_t* distanceCodeList,
+	const uint8_t* distanceLengthList,
+	std::string& out)
+{
+	const auto& deflateTables = displayer::s_deflateTables();
+	for (const auto& token : tokenList)
+	{
+		if (token.length == 0)
+		{
+			writeBits(literalCodeList[token.value], literalLengthList[token.value], out);
+			continue;
+		}
+		uint8_t lengthIndex = deflateTables.lengthIndexList[token.length];
+		writeBits(literalCodeList[257 + lengthIndex], literalLengthList[257 + lengthIndex], out);
+		writeBits(token.length - displayer::s_lengthBaseList[lengthIndex], displayer::s_lengthExtraList[lengthIndex], out);
+		uint8_t distanceCode = deflateTables.getDistanceCode(token.value);
+		writeBits(distanceCodeList[distanceCode], distanceLengthList[distanceCode], out);
+		writeBits(token.value - displayer::s_distanceBaseList[distanceCode], displayer::s_distanceExtraList[distanceCode], out);
+	}
+	writeBits(literalCodeList[256], literalLengthList[256], out); // end of block
+}
+
+void DeflateEncoder::writeBits(uint32_t value, uint32_t bitCount_, std::string& out)
+{
+	bitBuffer |= static_cast<uint64_t>(value) << bitCount;
+	bitCount += bitCount_;
+	while (bitCount >= 8)
+	{
+		out += static_cast<char>(bitBuffer & 0xFF);
+		bitBuffer >>= 8;
+		bitCount -= 8;
+	}
+}
+
+void DeflateEncoder::alignToByte(std::string& out)
+{
+	if (bitCount > 0) writeBits(0, 8 - bitCount, out);
+}
+
+uint32_t DeflateEncoder::s_hash(const uint8_t* p)
+{
+	uint32_t value = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16;
+	return (value * 2654435761u) >> (32 - 15);
+}
+
+GzipStreambuf::GzipStreambuf(std::ostream& os_, bool bThreaded, size_t blockSize, uint32_t maxChainLength) :
+	os(os_), deflateEncoder(maxChainLength), putBuffer(std::max(blockSize, static_cast<size_t>(1)))
+{
+	// header: magic, deflate, no flag, no modification time, no extra flag, unknown OS
+	output.append("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\xFF", 10);
+	setp(putBuffer.data(), putBuffer.data() + putBuffer.size());
+	if (bThreaded)
+	{
+		workBuffer.resize(putBuffer.size());
+		workerThread = std::thread([this]() { work(); });
+	}
+}
+
+GzipStreambuf::~GzipStreambuf() { finish(); }
+
+void GzipStreambuf::finish()
+{
+	if (bFinished) return;
+	submit();
+	wait();
+	if (workerThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bStop = true;
+		}
+		condition.notify_all();
+		workerThread.join();
+	}
+	deflateEncoder.finish(output);
+	// trailer: crc32 and size of the input, little endian
+	for (int i = 0; i < 4; ++i) output += static_cast<char>((crc >> (8 * i)) & 0xFF);
+	for (int i = 0; i < 4; ++i) output += static_cast<char>((inputSize >> (8 * i)) & 0xFF);
+	writeOutput();
+	os.flush();
+	bFinished = true;
+	setp(nullptr, nullptr); // nothing can be written after
+}
+
+GzipStreambuf::int_type GzipStreambuf::overflow(int_type c)
+{
+	if (bFinished) return traits_type::eof();
+	submit();
+	if (!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize GzipStreambuf::xsputn(const char* s, std::streamsize n)
+{
+	if (bFinished) return 0;
+	std::streamsize written = 0;
+	while (written < n)
+	{
+		if (pptr() == epptr()) submit();
+		auto size = std::min(static_cast<std::streamsize>(epptr() - pptr()), n - written);
+		std::memcpy(pptr(), s + written, static_cast<size_t>(size));
+		pbump(static_cast<int>(size));
+		written += size;
+	}
+	return n;
+}
+
+int GzipStreambuf::sync()
+{
+	if (bFinished) return 0;
+	submit();
+	wait();
+	deflateEncoder.syncFlush(output);
+	writeOutput();
+	os.flush();
+	return os ? 0 : -1;
+}
+
+void GzipStreambuf::submit()
+{
+	size_t size = pptr() - pbase();
+	if (size == 0) return;
+	if (!workerThread.joinable())
+	{
+		compressBlock(pbase(), size);
+		writeOutput();
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.wait(lock, [this]() { return !bWorkPending; });
+		putBuffer.swap(workBuffer);
+		workSize = size;
+		bWorkPending = true;
+		lock.unlock();
+		condition.notify_all();
+	}
+	setp(putBuffer.data(), putBuffer.data() + putBuffer.size());
+}
+
+void GzipStreambuf::wait()
+{
+	if (!workerThread.joinable()) return;
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this]() { return !bWorkPending; });
+}
+
+void GzipStreambuf::compressBlock(const char* data, size_t size)
+{
+	crc = displayer::s_crc32(crc, data, size);
+	inputSize += static_cast<uint32_t>(size);
+	deflateEncoder.compress(data, size, output);
+}
+
+void GzipStreambuf::writeOutput()
+{
+	os.write(output.data(), static_cast<std::streamsize>(output.size()));
+	output.clear();
+}
+
+void GzipStreambuf::work()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		condition.wait(lock, [this]() { return bWorkPending || bStop; });
+		if (!bWorkPending) return;
+		lock.unlock();
+		compressBlock(workBuffer.data(), workSize);
+		writeOutput();
+		lock.lock();
+		bWorkPending = false;
+		condition.notify_all();
+	}
+}
+
+GzipOstream::GzipOstream(std::ostream& os, bool bThreaded, size_t blockSize, uint32_t maxChainLength) :
+	std::ostream(nullptr), gzipStreambuf(os, bThreaded, blockSize, maxChainLength)
+{
+	rdbuf(&gzipStreambuf);
+}
+
+void GzipOstream::finish() { gzipStreambuf.finish(); }
+
+#endif // DISPLAYER_IMPLEMENTATION
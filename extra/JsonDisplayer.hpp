@@ -3,6 +3,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdio>
 #include <unordered_set>
 
 #include "../Displayer.hpp"
@@ -41,6 +42,15 @@ private:
 	std::unordered_set<std::string> stringKeySet; // set of key that are strings
 };
 
+namespace displayer
+{
+	// return true if s is a number of the json grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+	bool isJsonNumber(const char* s, size_t size);
+
+	// write s with the escapes of a json string (the quotes around s are not written)
+	void writeJsonEscaped(std::ostream& os, const char* s, size_t size);
+} // namespace displayer
+
 // ============================================================
 // ============================================================
 // ===================== Implementations ======================
@@ -65,11 +75,13 @@ JsonDisplayer::JsonDisplayer(const SL& keyList) : JsonDisplayer(keyList, "\n", "
 
 JsonDisplayer::JsonDisplayer(const SL& keyList, const std::string& newline, const std::string& tab)
 {
+	stringKeySet = s_tmpStringKeySet();
+	s_tmpStringKeySet().clear();
 	push_back(displayer::string_("{"));
 	for (const auto& key : keyList)
 	{
 		baseKeyList.push_back(key);
-		if (displayer::globalDisplayFuncMap.count(key)) continue;
+		if (displayer::isDisplayerKey(key)) continue;
 		headerDisplayFuncMap.emplace(key, DisplayFunc(key));
 		push_back(displayer::string_(newline + tab + "\"" + key + "\": "));
 		if (stringKeySet.count(key))
@@ -90,57 +102,100 @@ JsonDisplayer::JsonDisplayer(const SL& keyList, const std::string& newline, cons
 		if (stringKeySet.count(keyList.back())) push_back(displayer::string_("\""));
 	}
 	push_back(displayer::string_(newline + "}"));
-	stringKeySet = s_tmpStringKeySet();
-	s_tmpStringKeySet().clear();
 }
 
 void JsonDisplayer::setKeyAsString(const std::string& key)
 {
-	auto it = begin();
-	it = std::find(it, end(), key);
+	if (!stringKeySet.insert(key).second) return;
+	auto it = std::find(begin(), end(), key);
 	while (it != end())
 	{
 		it = insert(it, displayer::string_("\""));
-		++it;
-		++it;
-		*it = displayer::string_("\",");
+		it += 2;
+		// the last key is followed by the closing brace instead of a comma
+		if (it != end() && *it == displayer::string_(",")) *it = displayer::string_("\",");
+		else
+			it = insert(it, displayer::string_("\""));
 		it = std::find(it, end(), key);
 	}
 }
 
 void JsonDisplayer::unsetKeyAsString(const std::string& key)
 {
-	auto it = begin();
-	it = std::find(it, end(), key);
+	if (stringKeySet.erase(key) == 0) return;
+	auto it = std::find(begin(), end(), key);
 	while (it != end())
 	{
 		it = erase(std::prev(it));
-		*it = displayer::string_(",");
+		++it;
+		if (*it == displayer::string_("\",")) *it = displayer::string_(",");
+		else
+			it = erase(it);
 		it = std::find(it, end(), key);
 	}
 }
 
 void JsonDisplayer::setStringKeySet(const std::unordered_set<std::string>& newStringKeySet)
 {
-	std::unordered_set<std::string> toSetAsStringSet;
-	std::set_difference(stringKeySet.begin(),
-		stringKeySet.end(),
-		newStringKeySet.begin(),
-		newStringKeySet.end(),
-		std::inserter(toSetAsStringSet, toSetAsStringSet.end()));
-	for (const auto& toSetAsString : toSetAsStringSet) setKeyAsString(toSetAsString);
-	std::unordered_set<std::string> toUnsetAsStringSet;
-	std::set_difference(stringKeySet.begin(),
-		stringKeySet.end(),
-		newStringKeySet.begin(),
-		newStringKeySet.end(),
-		std::inserter(toUnsetAsStringSet, toUnsetAsStringSet.end()));
-	for (const auto& toUnsetAsString : toUnsetAsStringSet) unsetKeyAsString(toUnsetAsString);
-	stringKeySet = newStringKeySet;
+	std::unordered_set<std::string> oldStringKeySet = stringKeySet;
+	for (const auto& key : oldStringKeySet)
+		if (!newStringKeySet.count(key)) unsetKeyAsString(key);
+	for (const auto& key : newStringKeySet) setKeyAsString(key);
 }
 
 const std::unordered_set<std::string>& JsonDisplayer::getStringKeySet() const { return stringKeySet; }
 
 const std::vector<std::string>& JsonDisplayer::getBaseKeyList() const { return baseKeyList; }
 
+namespace displayer
+{
+	bool isJsonNumber(const char* s, size_t size)
+	{
+		const char* p = s;
+		const char* end = s + size;
+		auto isDigit = [&p, end]() { return p < end && *p >= '0' && *p <= '9'; };
+		if (p < end && *p == '-') ++p;
+		if (!isDigit()) return false;
+		if (*p++ != '0')
+			while (isDigit()) ++p;
+		if (p < end && *p == '.')
+		{
+			++p;
+			if (!isDigit()) return false;
+			while (isDigit()) ++p;
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+			if (p < end && (*p == '+' || *p == '-')) ++p;
+			if (!isDigit()) return false;
+			while (isDigit()) ++p;
+		}
+		return p == end;
+	}
+
+	void writeJsonEscaped(std::ostream& os, const char* s, size_t size)
+	{
+		const char* begin = s;
+		for (const char* c = s; c < s + size; ++c)
+		{
+			if (*c != '"' && *c != '\\' && static_cast<uint8_t>(*c) >= 0x20) continue;
+			os.write(begin, c - begin);
+			if (*c == '"' || *c == '\\') os << '\\' << *c;
+			else if (*c == '\n')
+				os << "\\n";
+			else if (*c == '\t')
+				os << "\\t";
+			else
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<uint8_t>(*c));
+				os << escaped;
+			}
+			begin = c + 1;
+		}
+		os.write(begin, s + size - begin);
+	}
+} // namespace displayer
+
 #endif // DISPLAYER_IMPLEMENTATION
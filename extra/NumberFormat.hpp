@@ -0,0 +1,301 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "../Displayer.hpp"
+
+namespace displayer
+{
+	// DisplayFunc of numbers, written directly in the stream with the width, the fill and the adjustfield of os applied
+	// the fill '0' (or std::internal) puts the sign before the padding
+	// the value is stored in the DisplayFunc (numericValue), to be aggregated without being rendered
+	// groupSeparator is inserted every 3 digits of the integer part (0 for no grouping)
+	// these functions do not depend on the locale of os
+
+	// to use like this: DisplayFuncMap{{PersonKeys.money, int_(money, ',')}}
+	DisplayFunc int_(long long value, char groupSeparator = 0);
+	DisplayFunc uint_(unsigned long long value, char groupSeparator = 0);
+
+	// value with precision digits after the decimal point, rounded like printf("%.*f") (exact halves are rounded to even)
+	DisplayFunc fixed_(double value, int precision, char groupSeparator = 0);
+
+	// shortest representation that reads back to the same value (with an exponent like %g for large and small values)
+	DisplayFunc float_(double value);
+
+	// low level functions used by the DisplayFunc above, return the size written
+	// buffer must have a size of at least 32 (integers), getFixedBufferSize(precision) (formatFixed) or 32 (formatFloat)
+	size_t formatUint(char* buffer, unsigned long long value, char groupSeparator = 0);
+	size_t formatInt(char* buffer, long long value, char groupSeparator = 0);
+	size_t formatFixed(char* buffer, double value, int precision, char groupSeparator = 0);
+	size_t formatFloat(char* buffer, double value);
+
+	// size of the buffer of formatFixed, enough for the 309 digits (and their separators) of the largest double
+	size_t getFixedBufferSize(int precision);
+
+	// write the number according to the width, the fill and the adjustfield of os, then reset the width
+	void writeNumber(std::ostream& os, const char* s, size_t size);
+} // namespace displayer
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+namespace displayer
+{
+	static const char s_digitPairList[] = "00010203040506070809"
+										  "10111213141516171819"
+										  "20212223242526272829"
+										  "30313233343536373839"
+										  "40414243444546474849"
+										  "50515253545556575859"
+										  "60616263646566676869"
+										  "70717273747576777879"
+										  "80818283848586878889"
+										  "90919293949596979899";
+
+	size_t formatUint(char* buffer, unsigned long long value, char groupSeparator)
+	{
+		char tmp[32];
+		char* end = tmp + sizeof(tmp);
+		char* p = end;
+		if (groupSeparator == 0)
+		{
+			// 2 digits at a time, written from the end
+			while (value >= 100)
+			{
+				auto pairIndex = static_cast<size_t>(value % 100) * 2;
+				value /= 100;
+				*--p = s_digitPairList[pairIndex + 1];
+				*--p = s_digitPairList[pairIndex];
+			}
+			if (value >= 10)
+			{
+				auto pairIndex = static_cast<size_t>(value) * 2;
+				*--p = s_digitPairList[pairIndex + 1];
+				*--p = s_digitPairList[pairIndex];
+			}
+			else
+				*--p = static_cast<char>('0' + value);
+		}
+		else
+		{
+			// 3 digits then a separator
+			while (value >= 1000)
+			{
+				auto group = static_cast<size_t>(value % 1000);
+				value /= 1000;
+				*--p = s_digitPairList[(group % 100) * 2 + 1];
+				*--p = s_digitPairList[(group % 100) * 2];
+				*--p = static_cast<char>('0' + group / 100);
+				*--p = groupSeparator;
+			}
+			do
+			{
+				*--p = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value != 0);
+		}
+		size_t size = end - p;
+		std::memcpy(buffer, p, size);
+		return size;
+	}
+
+	size_t formatInt(char* buffer, long long value, char groupSeparator)
+	{
+		if (value >= 0) return formatUint(buffer, static_cast<unsigned long long>(value), groupSeparator);
+		buffer[0] = '-';
+		return 1 + formatUint(buffer + 1, 0ull - static_cast<unsigned long long>(value), groupSeparator);
+	}
+
+	size_t getFixedBufferSize(int precision) { return 448 + static_cast<size_t>(precision < 0 ? 0 : precision); }
+
+	// replace the decimal point of the C locale (used by snprintf and strtod) with '.'
+	static size_t s_normalizeDecimalPoint(char* buffer, size_t size)
+	{
+		const char* decimalPoint = std::localeconv()->decimal_point;
+		size_t decimalPointSize = std::strlen(decimalPoint);
+		if (decimalPointSize == 0 || (decimalPointSize == 1 && decimalPoint[0] == '.')) return size;
+		char* p = std::search(buffer, buffer + size, decimalPoint, decimalPoint + decimalPointSize);
+		if (p == buffer + size) return size;
+		*p = '.';
+		std::memmove(p + 1, p + decimalPointSize, (buffer + size) - (p + decimalPointSize));
+		return size - (decimalPointSize - 1);
+	}
+
+	// insert groupSeparator every 3 digits of the integer part of the number in buffer
+	static size_t s_insertGroupSeparators(char* buffer, size_t size, char groupSeparator)
+	{
+		size_t begin = buffer[0] == '-' ? 1 : 0;
+		size_t end = begin;
+		while (end < size && buffer[end] >= '0' && buffer[end] <= '9') ++end;
+		if (end - begin <= 3) return size;
+		size_t separatorCount = (end - begin - 1) / 3;
+		std::memmove(buffer + end + separatorCount, buffer + end, size - end);
+		// digits moved from the end, a separator before each group of 3
+		char* to = buffer + end + separatorCount;
+		for (size_t i = end, digitCount = 0; i > begin; --i, ++digitCount)
+		{
+			if (digitCount != 0 && digitCount % 3 == 0) *--to = groupSeparator;
+			*--to = buffer[i - 1];
+		}
+		return size + separatorCount;
+	}
+
+	size_t formatFixed(char* buffer, double value, int precision, char groupSeparator)
+	{
+		if (precision < 0) precision = 0;
+		static const double s_pow10List[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+		double scaled = precision < 10 ? std::fabs(value) * s_pow10List[precision] : 0;
+		if (precision >= 10 || !(scaled < 9e15)) // not exactly representable as an integer, or nan/inf
+		{
+			int size = std::snprintf(buffer, getFixedBufferSize(precision), "%.*f", precision, value);
+			if (size < 0) return 0;
+			size_t result = s_normalizeDecimalPoint(buffer, static_cast<size_t>(size));
+			if (groupSeparator != 0 && std::isfinite(value)) result = s_insertGroupSeparators(buffer, result, groupSeparator);
+			return result;
+		}
+
+		// integer kernel on the scaled value, then insert the decimal point
+		// scaled is rounded, fma gives the exact error of the product: the exact scaled value is scaled + error
+		// the exact value is rounded to the nearest integer by the sign of its distance to the middle of the interval
+		// (scaled - floor(scaled) - 0.5 is exact near 0, and the sign of a rounded sum is the sign of the exact sum)
+		double error = std::fma(std::fabs(value), s_pow10List[precision], -scaled);
+		double floorScaled = std::floor(scaled);
+		double distanceToHalf = ((scaled - floorScaled) - 0.5) + error;
+		auto scaledValue = static_cast<unsigned long long>(floorScaled);
+		if (distanceToHalf > 0 || (distanceToHalf == 0 && scaledValue % 2 == 1)) ++scaledValue;
+		char* p = buffer;
+		if (std::signbit(value)) *p++ = '-';
+		unsigned long long divisor = 1;
+		for (int i = 0; i < precision; ++i) divisor *= 10;
+		p += formatUint(p, scaledValue / divisor, groupSeparator);
+		if (precision > 0)
+		{
+			*p++ = '.';
+			char fraction[32];
+			size_t fractionSize = formatUint(fraction, scaledValue % divisor);
+			for (size_t i = fractionSize; i < static_cast<size_t>(precision); ++i) *p++ = '0';
+			std::memcpy(p, fraction, fractionSize);
+			p += fractionSize;
+		}
+		return p - buffer;
+	}
+
+	size_t formatFloat(char* buffer, double value)
+	{
+		// %g removes the trailing zeros, so the precision 15 gives the shortest representation when it has 15 digits or less:
+		// a normal double is within 1.2e-16 (relative) of any shorter decimal that reads back to it, so rounding it to 15
+		// digits gives this decimal followed by zeros. Otherwise 16 digits are tried, then 17 always read back to the value.
+		// subnormal doubles are less precise, all the precisions are tried from 1
+		// snprintf and strtod use the same locale, the decimal point is replaced with '.' at the end
+		bool bSubnormal = value != 0 && std::fabs(value) < std::numeric_limits<double>::min();
+		int size = 0;
+		for (int precision = bSubnormal ? 1 : 15; precision <= 17; ++precision)
+		{
+			size = std::snprintf(buffer, 32, "%.*g", precision, value);
+			if (!std::isfinite(value) || precision == 17 || std::strtod(buffer, nullptr) == value) break;
+		}
+		return size < 0 ? 0 : s_normalizeDecimalPoint(buffer, static_cast<size_t>(size));
+	}
+
+	void writeNumber(std::ostream& os, const char* s, size_t size)
+	{
+		auto width = static_cast<size_t>(os.width() > 0 ? os.width() : 0);
+		os.width(0);
+		if (size >= width)
+		{
+			os.write(s, size);
+			return;
+		}
+		size_t paddingSize = width - size;
+		char fill = os.fill();
+		auto adjust = os.flags() & std::ios_base::adjustfield;
+		if (adjust == std::ios_base::left)
+		{
+			os.write(s, size);
+			for (size_t i = 0; i < paddingSize; ++i) os.put(fill);
+			return;
+		}
+		if ((adjust == std::ios_base::internal || fill == '0') && size > 0 && (s[0] == '-' || s[0] == '+'))
+		{
+			os.put(s[0]);
+			++s;
+			--size;
+		}
+		for (size_t i = 0; i < paddingSize; ++i) os.put(fill);
+		os.write(s, size);
+	}
+
+	DisplayFunc int_(long long value, char groupSeparator)
+	{
+		DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(value, groupSeparator)
+		{
+			char buffer[32];
+			writeNumber(os, buffer, formatInt(buffer, value, groupSeparator));
+		};
+		displayFunc.bAppliesWidth = true;
+		displayFunc.bHasNumericValue = true;
+		displayFunc.numericValue = static_cast<double>(value);
+		return displayFunc;
+	}
+
+	DisplayFunc uint_(unsigned long long value, char groupSeparator)
+	{
+		DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(value, groupSeparator)
+		{
+			char buffer[32];
+			writeNumber(os, buffer, formatUint(buffer, value, groupSeparator));
+		};
+		displayFunc.bAppliesWidth = true;
+		displayFunc.bHasNumericValue = true;
+		displayFunc.numericValue = static_cast<double>(value);
+		return displayFunc;
+	}
+
+	DisplayFunc fixed_(double value, int precision, char groupSeparator)
+	{
+		DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(value, precision, groupSeparator)
+		{
+			// the buffer is on the heap only for the large precisions
+			char localBuffer[512];
+			std::string heapBuffer;
+			char* buffer = localBuffer;
+			if (getFixedBufferSize(precision) > sizeof(localBuffer))
+			{
+				heapBuffer.resize(getFixedBufferSize(precision));
+				buffer = &heapBuffer[0];
+			}
+			writeNumber(os, buffer, formatFixed(buffer, value, precision, groupSeparator));
+		};
+		displayFunc.bAppliesWidth = true;
+		displayFunc.bHasNumericValue = true;
+		displayFunc.numericValue = static_cast<double>(value);
+		return displayFunc;
+	}
+
+	DisplayFunc float_(double value)
+	{
+		DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(value)
+		{
+			char buffer[32];
+			writeNumber(os, buffer, formatFloat(buffer, value));
+		};
+		displayFunc.bAppliesWidth = true;
+		displayFunc.bHasNumericValue = true;
+		displayFunc.numericValue = static_cast<double>(value);
+		return displayFunc;
+	}
+} // namespace displayer
+
+#endif // DISPLAYER_IMPLEMENTATION
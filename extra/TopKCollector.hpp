@@ -0,0 +1,99 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "../Displayer.hpp"
+
+// object that keeps the k rows with the first sort keys, in O(k) memory
+// the sort key is extracted once per row and the DisplayFuncMap is only built for the rows that are kept
+// the kept rows are then displayed in order by any displayer (with its header and its borders)
+// Compare is std::less for the smallest keys, std::greater for the largest keys
+// rows with equal keys are kept and sorted in push order
+template <typename SortKey, typename Compare = std::less<SortKey>> class TopKCollector
+{
+public:
+	// to use like this: TopKCollector<double, std::greater<double>>(100) for the 100 largest values
+	// the default k keeps all the rows (sorted output)
+	explicit TopKCollector(size_t k_ = std::numeric_limits<size_t>::max(), const Compare& compare_ = Compare()) :
+		k(k_), compare(compare_)
+	{
+	}
+
+	// return true if a row with sortKey would be kept
+	bool accepts(const SortKey& sortKey) const
+	{
+		if (k == 0) return false;
+		if (heap.size() < k) return true;
+		return compare(sortKey, heap.front().sortKey); // equal keys of later rows are rejected
+	}
+
+	// rowBuilder returns the DisplayFuncMap of the row, it is only called if the row is kept
+	// the DisplayFuncMap is displayed later, so its DisplayFunc must only capture values
+	// to use like this: topKCollector.push(person.money, [&person]() { return person.toDisplayFuncMap(); })
+	template <typename RowBuilder> bool push(const SortKey& sortKey, RowBuilder&& rowBuilder)
+	{
+		if (!accepts(sortKey))
+		{
+			++pushCount;
+			return false;
+		}
+		if (heap.size() == k)
+		{
+			std::pop_heap(heap.begin(), heap.end(), HeapCompare{compare});
+			heap.pop_back();
+		}
+		heap.push_back(Entry{sortKey, pushCount++, rowBuilder()});
+		std::push_heap(heap.begin(), heap.end(), HeapCompare{compare});
+		return true;
+	}
+
+	// return the kept rows in order and clear the collector
+	std::vector<DisplayFuncMap> takeSorted()
+	{
+		std::sort_heap(heap.begin(), heap.end(), HeapCompare{compare});
+		std::vector<DisplayFuncMap> result;
+		result.reserve(heap.size());
+		for (auto& entry : heap) result.push_back(std::move(entry.displayFuncMap));
+		clear();
+		return result;
+	}
+
+	size_t size() const { return heap.size(); }
+
+	// number of rows pushed (kept or not) since the last clear
+	uint64_t getPushCount() const { return pushCount; }
+
+	void clear()
+	{
+		heap.clear();
+		pushCount = 0;
+	}
+
+private:
+	struct Entry
+	{
+		SortKey sortKey;
+		uint64_t index; // push order, to sort equal keys
+		DisplayFuncMap displayFuncMap;
+	};
+
+	// the front of the heap is the last row in the output order
+	struct HeapCompare
+	{
+		const Compare& compare;
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			if (compare(a.sortKey, b.sortKey)) return true;
+			if (compare(b.sortKey, a.sortKey)) return false;
+			return a.index < b.index;
+		}
+	};
+
+	size_t k;
+	Compare compare;
+	uint64_t pushCount = 0;
+	std::vector<Entry> heap;
+};
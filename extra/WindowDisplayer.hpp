@@ -0,0 +1,93 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+#pragma once
+
+#include "BoxDisplayer.hpp"
+
+// random access source of rows
+// to use like this: RowProvider{[&](size_t i) { return personList[i].toDisplayFuncMap(); }, personList.size()}
+struct RowProvider
+{
+	std::function<DisplayFuncMap(size_t rowIndex)> getRow;
+	size_t rowCount;
+};
+
+namespace displayer
+{
+	// return a copy of keyList with a setw_ before each key to display
+	// the width is the max display width of the key and of its value in sampleCount rows evenly spread over the rows
+	// use sampleCount >= rowProvider.rowCount to measure all the rows
+	// for non ASCII cells, pad them by display width too with BoxDisplayer::setDisplayWidthPadding(true)
+	SL withMeasuredWidths(const SL& keyList, const RowProvider& rowProvider, size_t sampleCount = 1000);
+} // namespace displayer
+
+// box displayer that only displays a window of the rows
+// column widths do not depend on the window, use displayer::withMeasuredWidths to fix them
+class WindowDisplayer : public BoxDisplayer
+{
+public:
+	using BoxDisplayer::BoxDisplayer;
+
+	// display the header, the rows [firstRow, firstRow + rowCount) and the bottom border
+	// only the rows of the window are retrieved from the rowProvider
+	// the footer of columnAggregator (if set) aggregates the rows of the window, it is reset on each display
+	OstreamFunc displayWindow(const RowProvider& rowProvider, size_t firstRow, size_t rowCount);
+};
+
+// ============================================================
+// ============================================================
+// ===================== Implementations ======================
+// ============================================================
+// ============================================================
+
+#ifdef DISPLAYER_IMPLEMENTATION
+
+namespace displayer
+{
+	SL withMeasuredWidths(const SL& keyList, const RowProvider& rowProvider, size_t sampleCount)
+	{
+		std::unordered_map<std::string, size_t> widthMap;
+		for (const auto& key : keyList)
+			if (!isDisplayerKey(key)) widthMap.emplace(key, displayWidth(key));
+
+		size_t rowCount = rowProvider.rowCount;
+		size_t step = sampleCount == 0 || sampleCount >= rowCount ? 1 : rowCount / sampleCount;
+		size_t measuredCount = 0;
+		for (size_t rowIndex = 0; rowIndex < rowCount && measuredCount < sampleCount; rowIndex += step, ++measuredCount)
+		{
+			DisplayFuncMap displayFuncMap = rowProvider.getRow(rowIndex);
+			for (auto& keyWidth : widthMap)
+				if (auto displayFunc = displayFuncMap.pFind(keyWidth.first))
+					keyWidth.second = std::max(keyWidth.second, displayWidth(displayFunc->toString()));
+		}
+
+		SL result;
+		for (const auto& key : keyList)
+		{
+			auto it = widthMap.find(key);
+			if (it != widthMap.end()) result.push_back(setw_(it->second));
+			result.push_back(key);
+		}
+		return result;
+	}
+} // namespace displayer
+
+OstreamFunc WindowDisplayer::displayWindow(const RowProvider& rowProvider, size_t firstRow, size_t rowCount)
+{
+	return OSTREAM_FUNC_LAMBDA(this, &rowProvider, firstRow, rowCount)
+	{
+		size_t endRow = std::min(rowProvider.rowCount, firstRow + std::min(rowCount, rowProvider.rowCount));
+		columnAggregator.reset(); // the footer aggregates the rows of this window only
+		displayHeader()(os);
+		if (firstRow >= endRow)
+		{
+			if (borderType & BorderFlag::BOTTOM) os << lineStr;
+			return os;
+		}
+		for (size_t rowIndex = firstRow; rowIndex < endRow; ++rowIndex)
+			display(rowProvider.getRow(rowIndex), rowIndex + 1 == endRow)(os << "\n");
+		return os;
+	};
+}
+
+#endif // DISPLAYER_IMPLEMENTATION
@@ -0,0 +1,158 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+// render a file written by BinaryRecorder as plain, box, csv or json text
+// usage: binary_decoder <file> [plain|box|csv|json]
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#define DISPLAYER_IMPLEMENTATION
+#include "BinaryDisplayer.hpp"
+#include "BoxDisplayer.hpp"
+#include "CsvDisplayer.hpp"
+#include "ExtraDisplayer.hpp"
+#include "JsonDisplayer.hpp"
+
+struct SchemaInfo
+{
+	SL keyList;
+	std::vector<size_t> widthList;
+	std::unordered_set<std::string> stringKeySet;
+	size_t rowCount = 0;
+};
+
+int main(int argc, char** argv)
+{
+	using namespace displayer;
+
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <file> [plain|box|csv|json]" << std::endl;
+		return 1;
+	}
+	std::string format = argc > 2 ? argv[2] : "plain";
+	std::ifstream ifs(argv[1], std::ios::binary);
+
+	// first pass: read the schemas and measure the columns
+	std::vector<uint64_t> schemaIdList;
+	std::unordered_map<uint64_t, SchemaInfo> schemaInfoMap;
+	BinaryDecoder measureDecoder(ifs);
+	bool bValid = measureDecoder.decode(
+		[&](uint64_t schemaId, const DisplayFuncMap& displayFuncMap)
+		{
+			SchemaInfo& schemaInfo = schemaInfoMap[schemaId];
+			++schemaInfo.rowCount;
+			for (size_t i = 0; i < schemaInfo.keyList.size(); ++i)
+			{
+				const auto& key = schemaInfo.keyList[i];
+				schemaInfo.widthList[i] = std::max(schemaInfo.widthList[i], displayWidth(displayFuncMap.at(key).toString()));
+				if (measureDecoder.getFieldType(schemaId, i) == BinaryFieldType::STRING_FIELD) schemaInfo.stringKeySet.insert(key);
+			}
+		},
+		[&](uint64_t schemaId, const SL& keyList)
+		{
+			SchemaInfo& schemaInfo = schemaInfoMap[schemaId];
+			if (schemaInfo.keyList.empty()) schemaIdList.push_back(schemaId);
+			schemaInfo.keyList = keyList;
+			schemaInfo.widthList.clear();
+			for (const auto& key : keyList) schemaInfo.widthList.push_back(displayWidth(key));
+		});
+	if (!bValid)
+	{
+		std::cerr << "invalid binary record file: " << argv[1] << std::endl;
+		return 1;
+	}
+
+	// second pass: one table per schema
+	for (auto schemaId : schemaIdList)
+	{
+		const SchemaInfo& schemaInfo = schemaInfoMap[schemaId];
+		SL sl{left_};
+		for (size_t i = 0; i < schemaInfo.keyList.size(); ++i)
+		{
+			if (format == "plain" && i != 0) sl.push_back(string_(" "));
+			sl.push_back(setw_(schemaInfo.widthList[i]));
+			sl.push_back(schemaInfo.keyList[i]);
+		}
+
+		std::unique_ptr<Displayer> pDisplayer;
+		std::unique_ptr<BoxDisplayer> pBoxDisplayer;
+		if (format == "box")
+		{
+			pBoxDisplayer.reset(new BoxDisplayer(sl, BorderPreset::DEFAULT));
+			pBoxDisplayer->setDisplayWidthPadding(true); // the widths are display widths
+			std::cout << pBoxDisplayer->displayHeader() << std::endl;
+		}
+		else if (format == "csv")
+		{
+			// the cells are quoted by escapedDisplayFuncMap, the header too
+			CsvDisplayer* pCsvDisplayer = new CsvDisplayer(schemaInfo.keyList, ",");
+			pDisplayer.reset(pCsvDisplayer);
+			DisplayFuncMap headerDisplayFuncMap;
+			for (const auto& key : schemaInfo.keyList)
+				headerDisplayFuncMap.emplace(key, DISPLAY_FUNC_LAMBDA(key) { writeCsvQuoted(os, key.data(), key.size()); });
+			std::cout << pCsvDisplayer->display(headerDisplayFuncMap) << "\n";
+		}
+		else if (format == "json")
+		{
+			// the quotes of the strings are written by escapedDisplayFuncMap
+			pDisplayer.reset(new JsonDisplayer(schemaInfo.keyList, " ", ""));
+		}
+		else
+		{
+			ExtraDisplayer* pExtraDisplayer = new ExtraDisplayer(sl);
+			pExtraDisplayer->bDisplayWidthPadding = true; // the widths are display widths
+			pDisplayer.reset(pExtraDisplayer);
+			std::cout << pExtraDisplayer->display(pExtraDisplayer->headerDisplayFuncMap) << "\n";
+		}
+
+		// json and csv cells are rendered, then escaped or quoted
+		bool bEscaped = format == "json" || format == "csv";
+		DisplayFuncMap escapedDisplayFuncMap;
+		std::ostringstream cellOss;
+
+		ifs.clear();
+		ifs.seekg(0);
+		size_t rowIndex = 0;
+		BinaryDecoder(ifs).decode(
+			[&](uint64_t rowSchemaId, const DisplayFuncMap& displayFuncMap)
+			{
+				if (rowSchemaId != schemaId) return;
+				if (bEscaped && escapedDisplayFuncMap.empty())
+				{
+					// the DisplayFunc of the decoder are the same for all the rows of the schema
+					for (const auto& key : schemaInfo.keyList)
+					{
+						const DisplayFunc* pDisplayFunc = &displayFuncMap.at(key);
+						bool bJson = format == "json";
+						bool bString = schemaInfo.stringKeySet.count(key) != 0;
+						escapedDisplayFuncMap.emplace(key,
+							DISPLAY_FUNC_LAMBDA(pDisplayFunc, &cellOss, bJson, bString)
+							{
+								cellOss.str(std::string());
+								(*pDisplayFunc)(cellOss);
+								std::string cell = cellOss.str();
+								if (!bJson) writeCsvQuoted(os, cell.data(), cell.size());
+								else if (bString)
+								{
+									os << '"';
+									writeJsonEscaped(os, cell.data(), cell.size());
+									os << '"';
+								}
+								else if (isJsonNumber(cell.data(), cell.size()) || cell == "true" || cell == "false")
+									os << cell;
+								else
+									os << "null"; // nan and inf
+							});
+					}
+				}
+				const DisplayFuncMap& rowDisplayFuncMap = bEscaped ? escapedDisplayFuncMap : displayFuncMap;
+				if (pBoxDisplayer) std::cout << pBoxDisplayer->display(rowDisplayFuncMap, ++rowIndex == schemaInfo.rowCount) << "\n";
+				else
+					std::cout << pDisplayer->display(rowDisplayFuncMap) << "\n";
+			});
+		std::cout << std::endl;
+	}
+	return 0;
+}
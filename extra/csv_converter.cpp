@@ -0,0 +1,359 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+// convert a delimited file to box, json or csv text
+// usage: csv_converter <file> [box|json|csv] [delimiter] [sampleCount]
+// the input is memory mapped and the rows are streamed: the memory used does not depend on the size of the file
+// the first row is the header, the column widths of the box are measured on the first sampleCount rows (1000 by default)
+// a duplicate column name gets a suffix (a, a_2, a_3...), the csv output uses the delimiter of the input
+
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define DISPLAYER_IMPLEMENTATION
+#include "BoxDisplayer.hpp"
+#include "CsvDisplayer.hpp"
+#include "JsonDisplayer.hpp"
+
+// read only memory mapping of a file
+class MappedFile
+{
+public:
+	explicit MappedFile(const char* path)
+	{
+#ifdef _WIN32
+		hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(hFile, &fileSize)) return;
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size == 0)
+		{
+			bValid = true;
+			return;
+		}
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!hMapping) return;
+		data = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+		bValid = data != nullptr;
+#else
+		fd = open(path, O_RDONLY);
+		if (fd < 0) return;
+		struct stat st;
+		if (fstat(fd, &st) != 0) return;
+		size = static_cast<size_t>(st.st_size);
+		if (size == 0)
+		{
+			bValid = true;
+			return;
+		}
+		void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) return;
+		madvise(p, size, MADV_SEQUENTIAL);
+		data = static_cast<const char*>(p);
+		bValid = true;
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (hMapping) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (data) munmap(const_cast<char*>(data), size);
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool bValid = false;
+	const char* data = nullptr;
+	size_t size = 0;
+
+private:
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+// view of a cell in the mapped file (or in the unescaped string of a quoted cell)
+struct CellView
+{
+	const char* data = nullptr;
+	size_t size = 0;
+	std::string unescaped; // only used by quoted cells containing ""
+	bool bUnescaped = false;
+};
+
+static unsigned s_countTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// return the first delimiter, '\n' or '\r' in [p, end), or end
+static const char* s_findCellEnd(const char* p, const char* end, char delimiter)
+{
+#ifdef DISPLAYER_SSE2
+	const __m128i delimiterX16 = _mm_set1_epi8(delimiter);
+	const __m128i newlineX16 = _mm_set1_epi8('\n');
+	const __m128i carriageReturnX16 = _mm_set1_epi8('\r');
+	for (; p + 16 <= end; p += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, delimiterX16),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, newlineX16), _mm_cmpeq_epi8(chunk, carriageReturnX16)));
+		auto mask = static_cast<unsigned>(_mm_movemask_epi8(match));
+		if (mask != 0) return p + s_countTrailingZeros(mask);
+	}
+#endif
+	for (; p < end; ++p)
+		if (*p == delimiter || *p == '\n' || *p == '\r') return p;
+	return end;
+}
+
+// parse the row starting at p, cellList is resized to the number of cells of the row
+// return the beginning of the next row
+static const char* s_parseRow(const char* p, const char* end, char delimiter, std::vector<CellView>& cellList)
+{
+	size_t cellCount = 0;
+	for (;;)
+	{
+		if (cellCount == cellList.size()) cellList.emplace_back();
+		CellView& cell = cellList[cellCount++];
+		if (p < end && *p == '"')
+		{
+			// quoted cell: the content is a view unless it contains escaped quotes
+			const char* begin = ++p;
+			bool bEscaped = false;
+			for (;;)
+			{
+				auto quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+				if (!quote)
+				{
+					p = end;
+					break;
+				}
+				p = quote + 1;
+				if (p < end && *p == '"')
+				{
+					bEscaped = true;
+					++p;
+					continue;
+				}
+				break;
+			}
+			const char* cellEnd = p > begin && p[-1] == '"' ? p - 1 : p;
+			if (bEscaped)
+			{
+				cell.unescaped.clear();
+				for (const char* c = begin; c < cellEnd; ++c)
+				{
+					cell.unescaped += *c;
+					if (*c == '"') ++c;
+				}
+				cell.bUnescaped = true;
+			}
+			else
+			{
+				cell.bUnescaped = false;
+				cell.data = begin;
+				cell.size = cellEnd - begin;
+			}
+			p = s_findCellEnd(p, end, delimiter); // ignore the characters after the closing quote
+		}
+		else
+		{
+			const char* cellEnd = s_findCellEnd(p, end, delimiter);
+			cell.bUnescaped = false;
+			cell.data = p;
+			cell.size = cellEnd - p;
+			p = cellEnd;
+		}
+		if (p < end && *p == delimiter)
+		{
+			++p;
+			continue;
+		}
+		break;
+	}
+	cellList.resize(cellCount);
+	// set once the cells are not moved anymore
+	for (auto& cell : cellList)
+		if (cell.bUnescaped)
+		{
+			cell.data = cell.unescaped.data();
+			cell.size = cell.unescaped.size();
+		}
+	if (p < end && *p == '\r') ++p;
+	if (p < end && *p == '\n') ++p;
+	return p;
+}
+
+static bool s_isJsonNumber(const CellView& cell) { return displayer::isJsonNumber(cell.data, cell.size); }
+
+int main(int argc, char** argv)
+{
+	using namespace displayer;
+
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <file> [box|json|csv] [delimiter] [sampleCount]" << std::endl;
+		return 1;
+	}
+	std::string format = argc > 2 ? argv[2] : "box";
+	char delimiter = argc > 3 && argv[3][0] ? argv[3][0] : ',';
+	size_t sampleCount = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1000;
+
+	MappedFile mappedFile(argv[1]);
+	if (!mappedFile.bValid)
+	{
+		std::cerr << "cannot read file: " << argv[1] << std::endl;
+		return 1;
+	}
+	const char* begin = mappedFile.data;
+	const char* end = begin + mappedFile.size;
+	if (begin == end) return 0;
+
+	static char outputBuffer[1 << 20];
+	std::ios::sync_with_stdio(false);
+	std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+
+	std::vector<CellView> cellList;
+	const char* p = s_parseRow(begin, end, delimiter, cellList);
+	// the keys must be unique: a duplicate column name gets a suffix (a, a_2, a_3...)
+	SL keyList;
+	std::unordered_set<std::string> keySet;
+	for (const auto& cell : cellList)
+	{
+		std::string name(cell.data, cell.size);
+		std::string key = name;
+		for (size_t suffix = 2; !keySet.insert(key).second; ++suffix) key = name + "_" + std::to_string(suffix);
+		keyList.push_back(key);
+	}
+	const char* firstRow = p;
+
+	// measure the columns on the first rows
+	// a column is numeric if its sampled cells are numbers or empty, and at least one is a number
+	std::vector<size_t> widthList;
+	std::vector<bool> isNumberList(keyList.size(), false);
+	std::vector<bool> isNotNumberList(keyList.size(), false);
+	for (const auto& key : keyList) widthList.push_back(displayWidth(key));
+	for (size_t rowIndex = 0; rowIndex < sampleCount && p < end; ++rowIndex)
+	{
+		p = s_parseRow(p, end, delimiter, cellList);
+		for (size_t i = 0; i < keyList.size() && i < cellList.size(); ++i)
+		{
+			widthList[i] = std::max(widthList[i], displayWidth(cellList[i].data, cellList[i].size));
+			if (cellList[i].size == 0) continue;
+			if (s_isJsonNumber(cellList[i])) isNumberList[i] = true;
+			else
+				isNotNumberList[i] = true;
+		}
+	}
+	for (size_t i = 0; i < keyList.size(); ++i)
+		if (isNotNumberList[i]) isNumberList[i] = false;
+
+	// DisplayFunc of each column, displaying the view of the current row
+	bool bJson = format == "json";
+	bool bCsv = format == "csv";
+	DisplayFuncMap rowDisplayFuncMap;
+	for (size_t i = 0; i < keyList.size(); ++i)
+	{
+		// in a numeric column, the json cells are checked again: empty cells are null, the other non numbers are strings
+		bool bJsonNumber = bJson && isNumberList[i];
+		DisplayFunc displayFunc = DISPLAY_FUNC_LAMBDA(&cellList, i, bJson, bJsonNumber, bCsv, delimiter)
+		{
+			if (i >= cellList.size())
+			{
+				if (bJson) os << "null";
+				else
+					writePadded(os, "", 0);
+				return;
+			}
+			const CellView& cell = cellList[i];
+			if (bJsonNumber && cell.size == 0) os << "null";
+			else if (bJsonNumber && s_isJsonNumber(cell))
+				os.write(cell.data, cell.size);
+			else if (bJson)
+			{
+				os << '"';
+				writeJsonEscaped(os, cell.data, cell.size);
+				os << '"';
+			}
+			else if (bCsv)
+				writeCsvQuoted(os, cell.data, cell.size, delimiter);
+			else
+				writePadded(os, cell.data, cell.size);
+		};
+		displayFunc.bAppliesWidth = true;
+		rowDisplayFuncMap.emplace(keyList[i], displayFunc);
+	}
+
+	if (bJson)
+	{
+		// the quotes of the string columns are written by rowDisplayFuncMap
+		JsonDisplayer jsonDisplayer(keyList, " ", "");
+		for (p = firstRow; p < end;)
+		{
+			p = s_parseRow(p, end, delimiter, cellList);
+			std::cout << jsonDisplayer.display(rowDisplayFuncMap) << '\n';
+		}
+	}
+	else if (bCsv)
+	{
+		// the cells are separated by the bare delimiter, so that the quoted cells can be read back
+		CsvDisplayer csvDisplayer(keyList, std::string(1, delimiter));
+		DisplayFuncMap headerDisplayFuncMap;
+		for (const auto& key : keyList)
+			headerDisplayFuncMap.emplace(key, DISPLAY_FUNC_LAMBDA(key, delimiter) { writeCsvQuoted(os, key.data(), key.size(), delimiter); });
+		std::cout << csvDisplayer.display(headerDisplayFuncMap) << '\n';
+		for (p = firstRow; p < end;)
+		{
+			p = s_parseRow(p, end, delimiter, cellList);
+			std::cout << csvDisplayer.display(rowDisplayFuncMap) << '\n';
+		}
+	}
+	else
+	{
+		SL sl;
+		for (size_t i = 0; i < keyList.size(); ++i)
+		{
+			sl.push_back(isNumberList[i] ? right_ : left_);
+			sl.push_back(setw_(widthList[i]));
+			sl.push_back(keyList[i]);
+		}
+		BoxDisplayer boxDisplayer(sl);
+		boxDisplayer.setDisplayWidthPadding(true); // the widths are display widths
+		std::cout << boxDisplayer.displayHeader();
+		for (p = firstRow; p < end;)
+		{
+			p = s_parseRow(p, end, delimiter, cellList);
+			std::cout << '\n' << boxDisplayer.display(rowDisplayFuncMap, p >= end);
+		}
+		std::cout << '\n';
+	}
+	std::cout.flush();
+	return 0;
+}
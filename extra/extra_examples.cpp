@@ -15,20 +15,20 @@ static const struct
 static std::string dec_ = []()
 {
 	std::string key = "dec_";
-	displayer::globalDisplayFuncMap.emplace(key, std::dec);
+	displayer::globalDisplayFuncMap().emplace(key, std::dec);
 	return key;
 }();
 
 static std::string hex_ = []()
 {
 	std::string key = "hex_";
-	displayer::globalDisplayFuncMap.emplace(key, std::hex);
+	displayer::globalDisplayFuncMap().emplace(key, std::hex);
 	return key;
 }();
 
 static std::string toupper_(const std::string& key)
 {
-	displayer::globalEdfMap.emplace(
+	displayer::globalEdfMap().emplace(
 		key, EDF_LAMBDA() {
 			std::string s = displayFunc.toString();
 			std::transform(s.begin(), s.end(), s.begin(), toupper);
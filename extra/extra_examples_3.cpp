@@ -0,0 +1,33 @@
+#include <iostream>
+
+#define DISPLAYER_IMPLEMENTATION
+#include "AsyncDisplayer.hpp"
+#include "ExtraDisplayer.hpp"
+
+static const struct
+{
+	std::string name = "name";
+	std::string age = "age";
+} PersonKeys;
+
+int main()
+{
+	using namespace displayer;
+
+	std::cout << "--- Example 9 ---" << std::endl;
+	ExtraDisplayer extraDisplayer(SL{
+		left_,
+		setw_(10),
+		PersonKeys.name,
+		PersonKeys.age,
+	});
+
+	{
+		AsyncDisplayer asyncDisplayer(extraDisplayer, std::cout, 1024, QueueFullPolicy::BLOCK);
+		asyncDisplayer.push(extraDisplayer.headerDisplayFuncMap);
+		asyncDisplayer.push(DisplayFuncMap(SPL{{PersonKeys.name, "Craig"}, {PersonKeys.age, "25"}}));
+		asyncDisplayer.push(DisplayFuncMap(SPL{{PersonKeys.name, "John"}, {PersonKeys.age, "17"}}));
+		asyncDisplayer.pushValues("Paula", 53); // values of name and age, in the order of the displayer
+		asyncDisplayer.flush();
+	} // remaining rows are displayed on destruction
+}
@@ -0,0 +1,74 @@
+// Copyright (c) Nicolas VENTER All rights reserved.
+
+// check the number formatters against printf on random values
+// usage: number_format_check [count]
+// return 1 and display the first mismatches if the output of fixed_ or float_ differs from printf
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#define DISPLAYER_IMPLEMENTATION
+#include "NumberFormat.hpp"
+
+// number of significant digits of a number like "-1.2500e+07" (3)
+static int s_getDigitCount(const std::string& s)
+{
+	std::string digitList;
+	for (char c : s)
+	{
+		if (c == 'e') break;
+		if (c >= '0' && c <= '9' && (c != '0' || !digitList.empty())) digitList += c;
+	}
+	while (!digitList.empty() && digitList.back() == '0') digitList.pop_back();
+	return static_cast<int>(digitList.size());
+}
+
+int main(int argc, char** argv)
+{
+	using namespace displayer;
+
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	std::mt19937_64 random(42);
+	size_t mismatchCount = 0;
+	auto check = [&mismatchCount](const std::string& name, const std::string& expected, const std::string& actual)
+	{
+		if (expected == actual) return;
+		if (++mismatchCount <= 10) std::cout << name << ": expected " << expected << ", got " << actual << std::endl;
+	};
+	char expected[512];
+	char actual[512];
+	for (size_t i = 0; i < count; ++i)
+	{
+		// values of every magnitude, and decimals with few digits (like prices) that are not exact in binary
+		double value = i % 2 == 0 ? std::ldexp(static_cast<double>(random() >> 11), static_cast<int>(random() % 80) - 60)
+								  : static_cast<double>(random() % 100000000) / std::pow(10.0, static_cast<double>(random() % 10));
+		if (random() % 2) value = -value;
+		int precision = static_cast<int>(random() % 12);
+
+		std::snprintf(expected, sizeof(expected), "%.*f", precision, value);
+		check("fixed_(" + std::string(expected) + ", " + std::to_string(precision) + ")",
+			expected,
+			std::string(actual, formatFixed(actual, value, precision)));
+
+		// float_ must read back to the same value, with the digit count of the lowest %g precision that reads back
+		int floatPrecision = 1;
+		for (; floatPrecision < 17; ++floatPrecision)
+		{
+			std::snprintf(expected, sizeof(expected), "%.*g", floatPrecision, value);
+			if (std::strtod(expected, nullptr) == value) break;
+		}
+		std::string floatString(actual, formatFloat(actual, value));
+		if (std::strtod(floatString.c_str(), nullptr) != value || s_getDigitCount(floatString) > floatPrecision)
+			check("float_", expected, floatString);
+	}
+	// exact halves are rounded to even, like printf
+	for (double value : {0.125, 0.375, 2.5, 3.5, -0.5, 1e15 + 0.5})
+	{
+		std::snprintf(expected, sizeof(expected), "%.*f", value == 0.125 || value == 0.375 ? 2 : 0, value);
+		check("fixed_ half", expected, std::string(actual, formatFixed(actual, value, value == 0.125 || value == 0.375 ? 2 : 0)));
+	}
+
+	std::cout << count << " values checked, " << mismatchCount << " mismatches" << std::endl;
+	return mismatchCount == 0 ? 0 : 1;
+}